@@ -0,0 +1,517 @@
+//
+// Created by FCWY on 26-10-17.
+//
+// offline throughput of the audio wrappers, no sound card needed:
+//     SDL_AUDIO_DRIVER=dummy ./audio_benchmark [--quick] > result.json
+// (disk works too, anything else is replaced by dummy)
+// build: c++ -std=c++20 -O2 -Iinclude -Iinclude/SDL3plus -I. benchmark/audio_benchmark.cpp -lSDL3
+//
+
+#include <SDL3/SDL_hints.h>
+#include <SDL3/SDL_init.h>
+#include <SDL3/SDL_version.h>
+#include "SDL_audio.hpp"
+#include "SDL_audio_convert.hpp"
+#include "SDL_audio_effect.hpp"
+#include "SDL_audio_mixer.hpp"
+#include "SDL_audio_resample.hpp"
+#include "SDL_audio_spatial.hpp"
+#include "SDL_audio_wav.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    struct Result {
+        std::string
+            group;
+        std::string
+            name;
+        double
+            ns_per_op;
+        // bytes of input handled per op, 0 when throughput makes no sense
+        double
+            bytes_per_op;
+        // free form extra metric (snr_db, ns_per_channel_second...)
+        std::string
+            extra;
+    };
+
+    std::vector<Result> results;
+    int repeats = 5;
+
+    /**
+     * best of `repeats` runs, each run calls op `iterations` times.
+     * the minimum is the least disturbed by the rest of the machine,
+     * which is what a regression tracker wants to compare.
+     */
+    template<typename F>
+    double measure(const int iterations, F&& op) {
+        auto best = std::chrono::nanoseconds::max();
+        for (int r = 0; r < repeats; ++ r) {
+            const auto begin = clock_type::now();
+            for (int i = 0; i < iterations; ++ i)
+                op();
+            best = SDL::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin));
+        }
+        return static_cast<double>(best.count()) / iterations;
+    }
+
+    void report(std::string group, std::string name, const double ns, const double bytes, std::string extra={}) {
+        results.push_back({std::move(group), std::move(name), ns, bytes, std::move(extra)});
+    }
+
+    std::string_view format_name(const SDL::AudioFormat format) noexcept {
+        switch (format) {
+        case SDL::AudioFormat::U8:    return "U8";
+        case SDL::AudioFormat::S8:    return "S8";
+        case SDL::AudioFormat::S16LE: return "S16LE";
+        case SDL::AudioFormat::S16BE: return "S16BE";
+        case SDL::AudioFormat::S32LE: return "S32LE";
+        case SDL::AudioFormat::S32BE: return "S32BE";
+        case SDL::AudioFormat::F32LE: return "F32LE";
+        case SDL::AudioFormat::F32BE: return "F32BE";
+        default:                      return "UNKNOWN";
+        }
+    }
+
+    // deterministic random bytes, the same input on every run
+    std::vector<std::byte> noise(const std::size_t bytes) {
+        auto ret = std::vector<std::byte>(bytes);
+        Uint32 state = 0x12345678;
+        for (auto& b: ret) {
+            state = state * 1664525u + 1013904223u;
+            b = static_cast<std::byte>(state >> 24);
+        }
+        return ret;
+    }
+
+    std::vector<float> sine(const std::size_t frames, const int channels, const double freq, const int rate) {
+        auto ret = std::vector<float>(frames * channels);
+        for (std::size_t i = 0; i < frames; ++ i)
+            for (int c = 0; c < channels; ++ c)
+                ret[i * channels + c] = static_cast<float>(0.5 * std::sin(2.0 * std::numbers::pi * freq * static_cast<double>(i) / rate));
+        return ret;
+    }
+
+    /**
+     * SNR of one channel against the best fitting sine of the known frequency,
+     * fitting amplitude and phase makes the figure independent of each resampler's delay.
+     * `skip` frames at both ends are ignored (filter warm up and tail).
+     */
+    double snr_db(const std::span<const float> samples, const int channels, const double freq, const int rate, const std::size_t skip) {
+        const auto frames = samples.size() / channels;
+        if (frames <= 2 * skip)
+            return 0.0;
+
+        double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0;
+        for (auto i = skip; i < frames - skip; ++ i) {
+            const auto w = 2.0 * std::numbers::pi * freq * static_cast<double>(i) / rate;
+            const auto s = std::sin(w), c = std::cos(w), x = static_cast<double>(samples[i * channels]);
+            ss += s * s; sc += s * c; cc += c * c; xs += x * s; xc += x * c;
+        }
+        const auto det = ss * cc - sc * sc;
+        const auto a = (xs * cc - xc * sc) / det;
+        const auto b = (xc * ss - xs * sc) / det;
+
+        double signal = 0, error = 0;
+        for (auto i = skip; i < frames - skip; ++ i) {
+            const auto w = 2.0 * std::numbers::pi * freq * static_cast<double>(i) / rate;
+            const auto fit = a * std::sin(w) + b * std::cos(w);
+            const auto e = static_cast<double>(samples[i * channels]) - fit;
+            signal += fit * fit;
+            error += e * e;
+        }
+        return 10.0 * std::log10(signal / SDL::max(error, 1e-30));
+    }
+
+    std::string number(const double v) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%.6g", std::isfinite(v) ? v : 0.0);
+        return buffer;
+    }
+
+    void stream_put_get() {
+        const auto spec = SDL::AudioSpec{SDL::AudioFormat::F32, 2, 48000};
+        for (const std::size_t block: {256u, 4096u, 65536u}) {
+            auto stream = SDL::AudioStream{spec, spec};
+            const auto in = noise(block);
+            auto out = std::vector<unsigned char>(block);
+
+            const auto ns = measure(256, [&] {
+                stream.put({reinterpret_cast<const unsigned char*>(in.data()), in.size()});
+                stream.get(out);
+            });
+            report("stream", "put_get/" + std::to_string(block), ns, static_cast<double>(block));
+        }
+    }
+
+    void convert_pairs() {
+        constexpr std::size_t frames = 4096;
+        for (const auto from: SDL::convert::formats)
+            for (const auto to: SDL::convert::formats)
+                for (int channels = 1; channels <= SDL::convert::max_channels; ++ channels) {
+                    const auto src_spec = SDL::AudioSpec{from, channels, 48000};
+                    const auto dst_spec = SDL::AudioSpec{to, channels, 48000};
+                    const auto src = noise(frames * src_spec.frame_size());
+                    auto dst = std::vector<std::byte>(SDL::converted_size(src_spec, src.size(), dst_spec));
+
+                    const auto name = std::string{format_name(from)} + "->" + std::string{format_name(to)} + "/" + std::to_string(channels);
+                    auto converter = SDL::AudioConverter{src_spec, dst_spec};
+                    const auto ns = measure(16, [&] {
+                        converter(src, dst);
+                    });
+                    report("convert", name, ns, static_cast<double>(src.size()));
+
+                    const auto ns_sdl = measure(16, [&] {
+                        Uint8* out = nullptr;
+                        int out_len = 0;
+                        SDL_ConvertAudioSamples(src_spec.legacy_addr(), reinterpret_cast<const Uint8*>(src.data()), static_cast<int>(src.size()), dst_spec.legacy_addr(), &out, &out_len);
+                        SDL_free(out);
+                    });
+                    report("convert_sdl", name, ns_sdl, static_cast<double>(src.size()));
+                }
+    }
+
+    void mixing() {
+        constexpr std::size_t samples = 48000 * 2 / 100;    // 10 ms of stereo 48k
+        // source frames mixed per second, comparable across formats unlike mb_per_s
+        const auto frames_per_s = [](const std::size_t count, const double ns) {
+            return "\"frames_per_s\": " + number(static_cast<double>(samples / 2 * count) / ns * 1e9);
+        };
+        for (const auto format: {SDL::AudioFormat::F32, SDL::AudioFormat::S16})
+            for (const std::size_t count: {1u, 4u, 16u}) {
+                const auto bytes = samples * SDL::bytesize(format);
+                auto sources_data = std::vector<std::vector<std::byte>>{};
+                auto sources = std::vector<SDL::MixSource>{};
+                for (std::size_t i = 0; i < count; ++ i) {
+                    auto& data = sources_data.emplace_back(noise(bytes));
+                    if (format == SDL::AudioFormat::F32)
+                        for (std::size_t k = 0; k < samples; ++ k) {
+                            const auto v = static_cast<float>(static_cast<int>(data[k * 4]) - 128) / 256.0f;
+                            std::memcpy(data.data() + k * 4, &v, sizeof v);
+                        }
+                }
+                for (auto& data: sources_data)
+                    sources.push_back({{reinterpret_cast<const Uint8*>(data.data()), data.size()}, 0.5f});
+
+                auto dst = std::vector<Uint8>(bytes);
+                const auto name = std::string{format == SDL::AudioFormat::F32 ? "F32" : "S16"} + "/" + std::to_string(count);
+
+                const auto ns = measure(256, [&] {
+                    std::memset(dst.data(), 0, dst.size());
+                    SDL::mix_audio(dst, sources, format);
+                });
+                report("mix", name, ns, static_cast<double>(bytes * count), frames_per_s(count, ns));
+
+                const auto ns_sdl = measure(256, [&] {
+                    std::memset(dst.data(), 0, dst.size());
+                    for (const auto& [data, gain]: sources)
+                        SDL_MixAudio(dst.data(), data.data(), static_cast<SDL_AudioFormat>(format), static_cast<Uint32>(bytes), gain);
+                });
+                report("mix_sdl", name, ns_sdl, static_cast<double>(bytes * count), frames_per_s(count, ns_sdl));
+            }
+    }
+
+    // 44.1k -> 48k, cost per channel-second of input and SNR of a 1 kHz tone
+    void resampling() {
+        constexpr int channels = 2, src_rate = 44100, dst_rate = 48000;
+        constexpr double tone = 1000.0;
+        constexpr std::size_t block = 441;
+        const auto input = sine(static_cast<std::size_t>(src_rate), channels, tone, src_rate);
+        const auto channel_seconds = static_cast<double>(channels);
+
+        for (const auto& [quality, name]: {
+            std::pair{SDL::ResampleQuality::FAST, "FAST"},
+            std::pair{SDL::ResampleQuality::MEDIUM, "MEDIUM"},
+            std::pair{SDL::ResampleQuality::BEST, "BEST"}
+        }) {
+            auto resampler = SDL::Resampler{channels, src_rate, dst_rate, quality};
+            auto output = std::vector<float>{};
+            // upsampling by 48 / 44.1, twice the block is plenty
+            auto out = std::vector<float>(2 * block * channels);
+
+            const auto run = [&] {
+                resampler.reset();
+                output.clear();
+                for (std::size_t i = 0; i < input.size(); i += block * channels) {
+                    const auto n = SDL::min(block * channels, input.size() - i);
+                    const auto got = resampler.process({input.data() + i, n}, out);
+                    output.insert(output.end(), out.begin(), out.begin() + static_cast<std::ptrdiff_t>(got * channels));
+                }
+            };
+            const auto ns = measure(1, run);
+            report("resample", name, ns, static_cast<double>(input.size() * sizeof(float)),
+                "\"ns_per_channel_second\": " + number(ns / channel_seconds) + ", \"snr_db\": " + number(snr_db(output, channels, tone, dst_rate, 256)));
+        }
+
+        auto stream = SDL::AudioStream{SDL::AudioSpec{SDL::AudioFormat::F32, channels, src_rate}, SDL::AudioSpec{SDL::AudioFormat::F32, channels, dst_rate}};
+        auto output = std::vector<float>{};
+        auto out = std::vector<unsigned char>(block * 4 * channels * sizeof(float));
+        const auto run = [&] {
+            stream.clear();
+            output.clear();
+            const auto drain = [&] {
+                for (int got; (got = stream.get(out)) > 0;)
+                    output.insert(output.end(), reinterpret_cast<const float*>(out.data()), reinterpret_cast<const float*>(out.data() + got));
+            };
+            for (std::size_t i = 0; i < input.size(); i += block * channels) {
+                const auto n = SDL::min(block * channels, input.size() - i);
+                stream.put({reinterpret_cast<const unsigned char*>(input.data() + i), n * sizeof(float)});
+                drain();
+            }
+            stream.flush();
+            drain();
+        };
+        const auto ns = measure(1, run);
+        report("resample", "SDL", ns, static_cast<double>(input.size() * sizeof(float)),
+            "\"ns_per_channel_second\": " + number(ns / channel_seconds) + ", \"snr_db\": " + number(snr_db(output, channels, tone, dst_rate, 256)));
+    }
+
+    /**
+     * one second of audio through a biquad and a compressor, the effect stages against
+     * the straightforward scalar loops they replace (per sample, std::log10 / std::pow per frame)
+     */
+    void effects() {
+        constexpr int rate = 48000;
+        for (const int channels: {1, 2, 6, 8}) {
+            const auto spec = SDL::AudioSpec{SDL::AudioFormat::F32, channels, rate};
+            const auto input = sine(rate, channels, 440.0, rate);
+            const auto bytes = static_cast<double>(input.size() * sizeof(float));
+            auto block = input;
+            const auto name = std::to_string(channels) + "ch";
+
+            auto filter = SDL::BiquadFilter{SDL::FilterType::LOWPASS, 2000.0f};
+            report("effect", "biquad/" + name, measure(16, [&] {
+                filter(spec, block);
+            }), bytes);
+
+            const auto k = SDL::effect::design(SDL::FilterType::LOWPASS, 2000.0f, rate, filter.q, 0.0f);
+            float z1[SDL::effect::max_channels]{}, z2[SDL::effect::max_channels]{};
+            report("effect_scalar", "biquad/" + name, measure(16, [&] {
+                for (std::size_t i = 0; i < block.size(); ++ i) {
+                    const auto c = i % channels;
+                    const auto x = block[i];
+                    const auto y = k.b0 * x + z1[c];
+                    z1[c] = k.b1 * x - k.a1 * y + z2[c];
+                    z2[c] = k.b2 * x - k.a2 * y;
+                    block[i] = y;
+                }
+            }), bytes);
+
+            auto compressor = SDL::Compressor{};
+            report("effect", "compressor/" + name, measure(16, [&] {
+                block = input;
+                compressor(spec, block);
+            }), bytes);
+
+            const auto attack = SDL::effect::time_constant(compressor.attack_ms, rate);
+            const auto release = SDL::effect::time_constant(compressor.release_ms, rate);
+            const auto slope = 1.0f / compressor.ratio - 1.0f;
+            auto reduction = 0.0f;
+            report("effect_scalar", "compressor/" + name, measure(16, [&] {
+                block = input;
+                for (std::size_t i = 0; i < block.size(); i += channels) {
+                    auto peak = 1e-9f;
+                    for (int c = 0; c < channels; ++ c)
+                        peak = SDL::max(peak, std::abs(block[i + c]));
+                    const auto over = 20.0f * std::log10(peak) - compressor.threshold_db;
+                    const auto target = over > 0.0f ? slope * over : 0.0f;
+                    reduction = target + (target < reduction ? attack : release) * (reduction - target);
+                    const auto gain = std::pow(10.0f, reduction / 20.0f);
+                    for (int c = 0; c < channels; ++ c)
+                        block[i + c] *= gain;
+                }
+            }), bytes);
+        }
+    }
+
+    /**
+     * one 512 frame block of N positional voices: the batched update + ramped mix
+     * against the per-voice path (atan2 / sqrt per voice, then a constant gain mix)
+     */
+    void spatial() {
+        constexpr std::size_t frames = 512;
+        const auto source = sine(frames, 1, 440.0, 48000);
+        for (const auto layout: {SDL::SpeakerLayout::STEREO, SDL::SpeakerLayout::SURROUND_51}) {
+            const auto channels = SDL::speaker_count(layout);
+            for (const std::size_t voices: {64u, 512u, 2048u}) {
+                auto spatializer = SDL::Spatializer{layout, voices};
+                for (std::size_t v = 0; v < voices; ++ v) {
+                    const auto angle = static_cast<float>(v) * 0.37f;
+                    spatializer.position(v, 8.0f * std::sin(angle), 0.5f, 8.0f * std::cos(angle));
+                }
+                const auto sources = std::vector<const float*>(voices, source.data());
+                auto out = std::vector<float>(frames * channels);
+                const auto bytes = static_cast<double>(voices * frames * sizeof(float));
+                const auto name = std::string{channels == 2 ? "stereo/" : "5.1/"} + std::to_string(voices);
+
+                report("spatial", name, measure(16, [&] {
+                    spatializer.update();
+                    spatializer.mix(sources, out);
+                }), bytes);
+
+                auto gains = std::vector<float>(voices * channels);
+                report("spatial_scalar", name, measure(16, [&] {
+                    for (std::size_t v = 0; v < voices; ++ v) {
+                        const auto x = spatializer.x[v], y = spatializer.y[v], z = spatializer.z[v];
+                        const auto d = std::sqrt(x * x + y * y + z * z);
+                        const auto attenuation = 1.0f / SDL::max(d, 1.0f);
+                        const auto azimuth = std::atan2(x, z);
+                        for (int c = 0; c < channels; ++ c)
+                            gains[v * channels + c] = attenuation * std::sqrt(0.5f + 0.5f * std::sin(azimuth + static_cast<float>(c)));
+                    }
+                    for (std::size_t v = 0; v < voices; ++ v)
+                        for (std::size_t i = 0; i < frames; ++ i)
+                            for (int c = 0; c < channels; ++ c)
+                                out[i * channels + c] += sources[v][i] * gains[v * channels + c];
+                }), bytes);
+            }
+        }
+    }
+
+    // per stream cost of batch bind + unbind, ranges of AudioStream& and spans of raw handles
+    void bind_unbind() {
+        auto device = SDL::AudioDevice{SDL::default_playback};
+        const auto spec = device.format().first;
+
+        auto streams = std::vector<std::unique_ptr<SDL::AudioStream>>{};
+        for (int i = 0; i < 1024; ++ i)
+            streams.push_back(std::make_unique<SDL::AudioStream>(spec, spec));
+
+        for (const std::size_t count: {1u, 4u, 16u, 64u, 256u, 1024u}) {
+            auto refs = std::vector<std::reference_wrapper<SDL::AudioStream>>{};
+            auto handles = std::vector<SDL_AudioStream*>{};
+            for (std::size_t i = 0; i < count; ++ i) {
+                refs.emplace_back(*streams[i]);
+                handles.push_back(streams[i] -> handle);
+            }
+
+            const auto ns = measure(64, [&] {
+                SDL::AudioStream::bind(device, refs);
+                SDL::AudioStream::unbind(refs);
+            });
+            report("bind_unbind", "range/" + std::to_string(count), ns, 0.0,
+                "\"ns_per_stream\": " + number(ns / static_cast<double>(count)));
+
+            const auto ns_span = measure(64, [&] {
+                SDL::AudioStream::bind(device, std::span<SDL_AudioStream* const>{handles});
+                SDL::AudioStream::unbind(std::span<SDL_AudioStream* const>{handles});
+            });
+            report("bind_unbind", "span/" + std::to_string(count), ns_span, 0.0,
+                "\"ns_per_stream\": " + number(ns_span / static_cast<double>(count)));
+        }
+    }
+
+    std::vector<std::byte> wav_file(const SDL::AudioSpec& spec, const std::size_t frames) {
+        const auto data_size = static_cast<Uint32>(frames * spec.frame_size());
+        auto ret = std::vector<std::byte>(44 + data_size);
+        auto* p = ret.data();
+        const auto le16 = [&p](const Uint16 v) { const auto x = SDL_Swap16LE(v); std::memcpy(p, &x, 2); p += 2; };
+        const auto le32 = [&p](const Uint32 v) { const auto x = SDL_Swap32LE(v); std::memcpy(p, &x, 4); p += 4; };
+        const auto tag = [&p](const char* s) { std::memcpy(p, s, 4); p += 4; };
+
+        tag("RIFF"); le32(36 + data_size); tag("WAVE");
+        tag("fmt "); le32(16);
+        le16(SDL::is_float(spec.format) ? SDL::wav::format_float : SDL::wav::format_pcm);
+        le16(static_cast<Uint16>(spec.channels));
+        le32(static_cast<Uint32>(spec.freq));
+        le32(static_cast<Uint32>(spec.freq * spec.frame_size()));
+        le16(static_cast<Uint16>(spec.frame_size()));
+        le16(static_cast<Uint16>(SDL::bitsize(spec.format)));
+        tag("data"); le32(data_size);
+
+        const auto samples = noise(data_size);
+        std::memcpy(p, samples.data(), data_size);
+        return ret;
+    }
+
+    void wav_parse() {
+        const auto path = std::filesystem::temp_directory_path() / "sdl3plus_audio_benchmark.wav";
+        for (const auto seconds: {1, 10}) {
+            const auto spec = SDL::AudioSpec{SDL::AudioFormat::S16LE, 2, 48000};
+            const auto file = wav_file(spec, static_cast<std::size_t>(spec.freq) * seconds);
+            std::ofstream{path, std::ios::binary}.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+
+            const auto name = std::to_string(seconds) + "s";
+            const auto ns_mem = measure(8, [&] {
+                auto loaded = SDL::load_wav(SDL_IOFromConstMem(file.data(), file.size()), true);
+            });
+            report("load_wav", "memory/" + name, ns_mem, static_cast<double>(file.size()));
+
+            const auto ns_file = measure(8, [&] {
+                auto loaded = SDL::load_wav(path);
+            });
+            report("load_wav", "file/" + name, ns_file, static_cast<double>(file.size()));
+
+            const auto ns_map = measure(8, [&] {
+                auto mapped = SDL::MappedWav{path};
+            });
+            report("mapped_wav", "file/" + name, ns_map, static_cast<double>(file.size()));
+        }
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    void print_json(const char* driver) {
+        std::printf("{\n  \"benchmark\": \"sdl3plus-audio\",\n  \"sdl_version\": %d,\n  \"driver\": \"%s\",\n  \"repeats\": %d,\n  \"results\": [\n",
+            SDL_GetVersion(), driver ? driver : "", repeats);
+        for (std::size_t i = 0; i < results.size(); ++ i) {
+            const auto& r = results[i];
+            std::printf("    {\"group\": \"%s\", \"name\": \"%s\", \"ns_per_op\": %s, \"mb_per_s\": %s%s%s}%s\n",
+                r.group.c_str(), r.name.c_str(), number(r.ns_per_op).c_str(),
+                number(r.bytes_per_op > 0 ? r.bytes_per_op / r.ns_per_op * 1e3 : 0.0).c_str(),
+                r.extra.empty() ? "" : ", ", r.extra.c_str(),
+                i + 1 == results.size() ? "" : ",");
+        }
+        std::printf("  ]\n}\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    for (int i = 1; i < argc; ++ i)
+        if (std::string_view{argv[i]} == "--quick")
+            repeats = 1;
+
+    const auto* requested = std::getenv("SDL_AUDIO_DRIVER");
+    if (!requested || (std::string_view{requested} != "dummy" && std::string_view{requested} != "disk"))
+        SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
+    if (!SDL_Init(SDL_INIT_AUDIO)) {
+        std::fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    try {
+        stream_put_get();
+        convert_pairs();
+        mixing();
+        resampling();
+        effects();
+        spatial();
+        wav_parse();
+        bind_unbind();
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "benchmark failed: %s (%s)\n", e.what(), SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    print_json(SDL_GetCurrentAudioDriver());
+    SDL_Quit();
+    return 0;
+}
@@ -10,9 +10,29 @@
 #include "SDL_stdinc.hpp"
 #include "SDL_assert.hpp"
 #include "SDL_asyncio.hpp"
+#include "SDL_asyncio_dispatcher.hpp"
+#include "SDL_asyncio_job.hpp"
+#include "SDL_asyncio_loader.hpp"
 #include "SDL_atomic.hpp"
 #include "SDL_audio.hpp"
+#include "SDL_audio_bus.hpp"
+#include "SDL_audio_cache.hpp"
+#include "SDL_audio_capture.hpp"
+#include "SDL_audio_channels.hpp"
+#include "SDL_audio_convert.hpp"
+#include "SDL_audio_effect.hpp"
+#include "SDL_audio_mixer.hpp"
+#include "SDL_audio_music.hpp"
+#include "SDL_audio_pool.hpp"
+#include "SDL_audio_probe.hpp"
+#include "SDL_audio_resample.hpp"
+#include "SDL_audio_ring.hpp"
+#include "SDL_audio_spatial.hpp"
+#include "SDL_audio_voice.hpp"
+#include "SDL_audio_wav.hpp"
 #include "SDL_bits.hpp"
 #include "SDL_blendmode.hpp"
+#include "SDL_cpuinfo.hpp"
+#include "SDL_intrin.hpp"
 
 #endif //SDL_HPP
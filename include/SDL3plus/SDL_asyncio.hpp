@@ -5,7 +5,22 @@
 #ifndef SDL_ASYNCIO_HPP
 #define SDL_ASYNCIO_HPP
 #include <SDL3/SDL_asyncio.h>
+#include <SDL3/SDL_assert.h>
+#include "SDL_stdinc.hpp"
+#include "SDL_cpuinfo.hpp"
+#include "SDL_error.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <coroutine>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace SDL::AsyncIO{
     enum class TaskType: UnderlyingType {
@@ -28,27 +43,29 @@ namespace SDL::AsyncIO{
 
     struct Outcome {
         SDL_AsyncIO*
-            asyncio;
+            asyncio{nullptr};
         TaskType
-            type;
+            type{TaskType::READ};
         Result
-            result;
+            result{Result::COMPLETE};
         void*
-            v_buffer;
+            v_buffer{nullptr};
         Uint64
-            offset;
+            offset{0};
         Uint64
-            bytes_requested;
+            bytes_requested{0};
         Uint64
-            bytes_transferred;
+            bytes_transferred{0};
         void*
-            v_userdata;
+            v_userdata{nullptr};
+
+        Outcome() noexcept=default;
 
         // ReSharper disable once CppNonExplicitConvertingConstructor
-        Outcome(const Outcome& underly) noexcept:
+        Outcome(const SDL_AsyncIOOutcome& underly) noexcept:
             asyncio{underly.asyncio},
-            type{underly.type},
-            result{underly.result},
+            type{static_cast<TaskType>(underly.type)},
+            result{static_cast<Result>(underly.result)},
             v_buffer{underly.buffer},
             offset{underly.offset},
             bytes_requested{underly.bytes_requested},
@@ -56,7 +73,7 @@ namespace SDL::AsyncIO{
             v_userdata{underly.userdata}{}
 
         // ReSharper disable once CppNonExplicitConversionOperator
-        operator SDL_AsyncIOOutcome () noexcept {
+        operator SDL_AsyncIOOutcome () const noexcept {
             return {
                 asyncio,
                 static_cast<SDL_AsyncIOTaskType>(static_cast<UnderlyingType>(type)),
@@ -71,12 +88,12 @@ namespace SDL::AsyncIO{
 
         template<typename T>
         T* buffer() const noexcept {
-            return static_cast<T*>(buffer);
+            return static_cast<T*>(v_buffer);
         }
 
         template<typename T>
         T* userdata() const noexcept {
-            return static_cast<T*>(userdata);
+            return static_cast<T*>(v_userdata);
         }
 
         Outcome& operator = (const SDL_AsyncIOOutcome& sdl_async_io_outcome) {
@@ -92,6 +109,106 @@ namespace SDL::AsyncIO{
         }
     };
 
+    // one read or write of a batch, see TaskQueue::submit and Task::submission
+    struct Submission {
+        SDL_AsyncIO*
+            asyncio;
+        TaskType
+            type;
+        void*
+            buffer;
+        Uint64
+            offset;
+        Uint64
+            size;
+        void*
+            userdata{nullptr};
+    };
+
+    /**
+     * what the userdata of a request points to when it is awaited:
+     * whoever drains the queue hands the outcome to complete().
+     * outcomes with no userdata (e.g. the close a Task queues on destruction) are skipped by dispatch()
+     */
+    struct Completion {
+        void (*on_complete)(Completion*, const Outcome&) noexcept{nullptr};
+
+        void complete(const Outcome& outcome) noexcept {
+            on_complete(this, outcome);
+        }
+
+        static bool dispatch(const Outcome& outcome) noexcept {
+            const auto completion = outcome.userdata<Completion>();
+            if (!completion)
+                return false;
+            completion -> complete(outcome);
+            return true;
+        }
+    };
+
+    /**
+     * co_await-able read or write. it lives in the awaiting coroutine's frame and is its own userdata,
+     * nothing is allocated per request. the coroutine resumes wherever its outcome is dispatched
+     * (see Scheduler), with the Outcome as the result of the co_await.
+     * a request SDL refuses to queue resumes at once with Result::FAILURE
+     */
+    struct Request: Completion {
+        SDL_AsyncIO*
+            asyncio;
+        SDL_AsyncIOQueue*
+            queue;
+        TaskType
+            type;
+        void*
+            buffer;
+        Uint64
+            offset;
+        Uint64
+            size;
+        std::coroutine_handle<>
+            waiter{};
+        Outcome
+            outcome{};
+
+        Request(SDL_AsyncIO* asyncio, SDL_AsyncIOQueue* queue, const TaskType type, void* buffer, const Uint64 offset, const Uint64 size) noexcept:
+            Completion{resume},
+            asyncio{asyncio},
+            queue{queue},
+            type{type},
+            buffer{buffer},
+            offset{offset},
+            size{size} {}
+
+        static bool await_ready() noexcept {
+            return false;
+        }
+
+        bool await_suspend(const std::coroutine_handle<> h) noexcept {
+            waiter = h;
+            outcome.asyncio = asyncio;
+            outcome.type = type;
+            outcome.result = Result::FAILURE;
+            outcome.v_buffer = buffer;
+            outcome.offset = offset;
+            outcome.bytes_requested = size;
+            // nothing may touch *this once queued, the outcome can resume the coroutine on another thread right away
+            const auto userdata = static_cast<void*>(static_cast<Completion*>(this));
+            return type == TaskType::WRITE
+                ? SDL_WriteAsyncIO(asyncio, buffer, offset, size, queue, userdata)
+                : SDL_ReadAsyncIO(asyncio, buffer, offset, size, queue, userdata);
+        }
+
+        Outcome await_resume() const noexcept {
+            return outcome;
+        }
+
+        static void resume(Completion* self, const Outcome& outcome) noexcept {
+            const auto request = static_cast<Request*>(self);
+            request -> outcome = outcome;
+            request -> waiter.resume();
+        }
+    };
+
     struct TaskQueue {
         using handle_t = SDL_AsyncIOQueue*;
 
@@ -100,7 +217,7 @@ namespace SDL::AsyncIO{
         handle_t
             handle{nullptr};
 
-        TaskQueue() noexcept:
+        TaskQueue():
             ref_count{new std::atomic_uint64_t{1}},
             handle{SDL_CreateAsyncIOQueue()}{
             // ReSharper disable once CppDFAConstantConditions
@@ -117,28 +234,71 @@ namespace SDL::AsyncIO{
         TaskQueue(TaskQueue&& expired) noexcept{
             std::swap(ref_count, expired.ref_count);
             std::swap(handle, expired.handle);
-            ++ *ref_count;
+        }
+
+        TaskQueue& operator = (TaskQueue other) noexcept {
+            std::swap(ref_count, other.ref_count);
+            std::swap(handle, other.handle);
+            return *this;
         }
 
         // ReSharper disable CppMemberFunctionMayBeConst
         bool get(Outcome& result) noexcept {
             SDL_AsyncIOOutcome o;
             const auto ret = SDL_GetAsyncIOResult(handle, &o);
-            result = o;
+            if (ret)
+                result = o;
             return ret;
         }
 
         bool wait(Outcome& result, const std::chrono::milliseconds timeout) noexcept {
             SDL_AsyncIOOutcome o;
-            const auto ret = SDL_WaitAsyncIOResult(handle, &o, timeout.count());
-            result = o;
+            const auto ret = SDL_WaitAsyncIOResult(handle, &o, static_cast<Sint32>(timeout.count()));
+            if (ret)
+                result = o;
             return ret;
         }
 
         bool wait(Outcome& result) noexcept {
             SDL_AsyncIOOutcome o;
             const auto ret = SDL_WaitAsyncIOResult(handle, &o, -1);
-            result = o;
+            if (ret)
+                result = o;
+            return ret;
+        }
+
+        // every outcome already there, up to outcomes.size(), without waiting. returns how many
+        std::size_t drain(const std::span<Outcome> outcomes) noexcept {
+            std::size_t ret = 0;
+            SDL_AsyncIOOutcome o;
+            while (ret < outcomes.size() && SDL_GetAsyncIOResult(handle, &o))
+                outcomes[ret ++] = o;
+            return ret;
+        }
+
+        // waits up to timeout for the first outcome, then drains the rest: one wakeup per batch
+        std::size_t drain(const std::span<Outcome> outcomes, const std::chrono::milliseconds timeout) noexcept {
+            SDL_AsyncIOOutcome o;
+            if (outcomes.empty() || !SDL_WaitAsyncIOResult(handle, &o, static_cast<Sint32>(timeout.count())))
+                return 0;
+            outcomes[0] = o;
+            return 1 + drain(outcomes.subspan(1));
+        }
+
+        /**
+         * queues a batch of reads / writes on this queue, in order.
+         * stops at the first one SDL refuses, returns how many were queued
+         */
+        std::size_t submit(const std::span<const Submission> batch) noexcept {
+            std::size_t ret = 0;
+            for (const auto& s: batch) {
+                const auto ok = s.type == TaskType::WRITE
+                    ? SDL_WriteAsyncIO(s.asyncio, s.buffer, s.offset, s.size, handle, s.userdata)
+                    : SDL_ReadAsyncIO(s.asyncio, s.buffer, s.offset, s.size, handle, s.userdata);
+                if (!ok)
+                    break;
+                ++ ret;
+            }
             return ret;
         }
 
@@ -156,6 +316,50 @@ namespace SDL::AsyncIO{
         }
         // ReSharper restore CppMemberFunctionMayBeConst
 
+        /**
+         * co_await-able LoadFileAsync, the Outcome's buffer holds the whole file
+         * (plus a null terminator) and must be released with SDL_free
+         */
+        struct Load: Completion {
+            SDL_AsyncIOQueue*
+                queue;
+            std::u8string
+                path;
+            std::coroutine_handle<>
+                waiter{};
+            Outcome
+                outcome{};
+
+            Load(SDL_AsyncIOQueue* queue, const std::filesystem::path& file):
+                Completion{resume},
+                queue{queue},
+                path{file.generic_u8string()} {}
+
+            static bool await_ready() noexcept {
+                return false;
+            }
+
+            bool await_suspend(const std::coroutine_handle<> h) noexcept {
+                waiter = h;
+                outcome.result = Result::FAILURE;
+                return SDL_LoadFileAsync(reinterpret_cast<const char*>(path.c_str()), queue, static_cast<Completion*>(this));
+            }
+
+            Outcome await_resume() const noexcept {
+                return outcome;
+            }
+
+            static void resume(Completion* self, const Outcome& outcome) noexcept {
+                const auto load = static_cast<Load*>(self);
+                load -> outcome = outcome;
+                load -> waiter.resume();
+            }
+        };
+
+        Load async_load(const std::filesystem::path& file) const {
+            return {handle, file};
+        }
+
         ~TaskQueue() {
             if (ref_count == nullptr)
                 return;
@@ -169,6 +373,219 @@ namespace SDL::AsyncIO{
         }
     };
 
+    /**
+     * recycles page aligned I/O buffers for Tasks.
+     *
+     * sizes round up to size classes of page_size * 2^k (the system's page size), every class keeps its free buffers,
+     * acquire() hands one back before it allocates (SDL::aligned::alloc, page aligned, direct I/O friendly),
+     * the free lists are reserved as buffers are created, so release() never allocates either.
+     * once warmed up (or reserve()d), steady state streaming does no heap allocation.
+     * thread safe. buffers still out when the pool goes are leaked, not freed under the borrower,
+     * the pool must outlive the closes of the Tasks borrowing from it (see Task's destructor).
+     */
+    struct BufferPool {
+        static constexpr std::size_t class_count = 32;
+
+        /**
+         * hands a buffer back once the outcome carrying it as userdata is dispatched.
+         * one is created per buffer and recycled, so returning this way does not allocate
+         */
+        struct Return: Completion {
+            BufferPool*
+                pool;
+            std::byte*
+                buffer{nullptr};
+            std::size_t
+                size{0};
+
+            explicit Return(BufferPool* pool) noexcept:
+                Completion{on_return},
+                pool{pool} {}
+
+            // buffer and Return go back together, an acquire in between would find a buffer without a spare
+            static void on_return(Completion* self, const Outcome&) noexcept {
+                const auto r = static_cast<Return*>(self);
+                auto guard = std::scoped_lock{r -> pool -> lock};
+                r -> pool -> put_back(r -> buffer, r -> size);
+                r -> pool -> spare_returns.push_back(r);
+            }
+        };
+
+        struct Stats {
+            // buffers created by aligned::alloc
+            Uint64
+                allocated;
+            // acquires served from a free list
+            Uint64
+                reused;
+            std::size_t
+                outstanding;
+            std::size_t
+                high_water;
+            std::size_t
+                outstanding_bytes;
+            std::size_t
+                high_water_bytes;
+        };
+
+        struct Class {
+            std::vector<std::byte*>
+                free;
+            // buffers of this class in existence, the free list has room for all of them
+            std::size_t
+                total{0};
+        };
+
+        // alignment and smallest class, 4096 if SDL does not know
+        std::size_t
+            page_size;
+        std::array<Class, class_count>
+            classes;
+        // as many as buffers were ever created, so a spare one exists for every buffer out
+        std::vector<std::unique_ptr<Return>>
+            returns;
+        std::vector<Return*>
+            spare_returns;
+        Stats
+            counters{};
+        std::mutex
+            lock;
+
+        BufferPool() noexcept:
+            page_size{std::bit_ceil(static_cast<std::size_t>(SDL::max(SDL::cpuinfo::page_size(), 4096)))} {}
+        BufferPool(const BufferPool&)=delete;
+        BufferPool& operator = (const BufferPool&)=delete;
+
+        ~BufferPool() noexcept {
+            trim();
+        }
+
+        std::size_t class_of(const std::size_t size) const noexcept {
+            return static_cast<std::size_t>(std::bit_width((SDL::max<std::size_t>(size, 1) - 1) / page_size));
+        }
+
+        std::size_t class_size(const std::size_t index) const noexcept {
+            return page_size << index;
+        }
+
+        // size rounded up to its class, what acquire(size) really hands out
+        std::size_t capacity(const std::size_t size) const noexcept {
+            return class_size(class_of(size));
+        }
+
+        std::byte* acquire(const std::size_t size) {
+            const auto index = class_of(size);
+            if (index >= class_count) {
+                SDL_SetError("buffer of %zu bytes is beyond the largest pool class", size);
+                throw Error{};
+            }
+
+            auto guard = std::scoped_lock{lock};
+            auto& c = classes[index];
+            std::byte* ret;
+            if (!c.free.empty()) {
+                ret = c.free.back();
+                c.free.pop_back();
+                ++ counters.reused;
+            }
+            else {
+                ret = create(index);
+            }
+
+            ++ counters.outstanding;
+            counters.outstanding_bytes += class_size(index);
+            counters.high_water = SDL::max(counters.high_water, counters.outstanding);
+            counters.high_water_bytes = SDL::max(counters.high_water_bytes, counters.outstanding_bytes);
+            return ret;
+        }
+
+        // size as given to acquire
+        void release(std::byte* buffer, const std::size_t size) noexcept {
+            if (!buffer)
+                return;
+            auto guard = std::scoped_lock{lock};
+            put_back(buffer, size);
+        }
+
+        // lock held
+        void put_back(std::byte* buffer, const std::size_t size) noexcept {
+            const auto index = class_of(size);
+            classes[index].free.push_back(buffer);
+            -- counters.outstanding;
+            counters.outstanding_bytes -= class_size(index);
+        }
+
+        /**
+         * the completion to pass as the userdata of the last request touching an outstanding buffer,
+         * the buffer (size as given to acquire) goes back when that outcome is dispatched.
+         * every outstanding buffer has a spare, nullptr only for a buffer released twice or not from this pool:
+         * the caller then leaks it rather than freeing it under requests in flight
+         */
+        Completion* release_on(std::byte* buffer, const std::size_t size) noexcept {
+            auto guard = std::scoped_lock{lock};
+            SDL_assert(!spare_returns.empty());
+            if (spare_returns.empty())
+                return nullptr;
+            const auto ret = spare_returns.back();
+            spare_returns.pop_back();
+            ret -> buffer = buffer;
+            ret -> size = size;
+            return ret;
+        }
+
+        // have at least count buffers able to hold size bytes, out or free
+        void reserve(const std::size_t size, const std::size_t count) {
+            const auto index = class_of(size);
+            if (index >= class_count) {
+                SDL_SetError("buffer of %zu bytes is beyond the largest pool class", size);
+                throw Error{};
+            }
+
+            auto guard = std::scoped_lock{lock};
+            auto& c = classes[index];
+            while (c.total < count)
+                c.free.push_back(create(index));
+        }
+
+        // frees every buffer not out, returns how many bytes
+        std::size_t trim() noexcept {
+            auto guard = std::scoped_lock{lock};
+            std::size_t ret = 0;
+            for (std::size_t i = 0; i < class_count; ++ i) {
+                auto& c = classes[i];
+                for (const auto buffer: c.free)
+                    aligned::free(buffer);
+                ret += c.free.size() * class_size(i);
+                c.total -= c.free.size();
+                // the capacity stays, buffers still out come back without allocating
+                c.free.clear();
+            }
+            return ret;
+        }
+
+        Stats stats() {
+            auto guard = std::scoped_lock{lock};
+            return counters;
+        }
+
+        // lock held
+        std::byte* create(const std::size_t index) {
+            auto& c = classes[index];
+            c.free.reserve(c.total + 1);
+            returns.reserve(returns.size() + 1);
+            spare_returns.reserve(returns.size() + 1);
+            auto record = std::make_unique<Return>(this);
+            const auto ret = static_cast<std::byte*>(aligned::alloc(page_size, class_size(index)));
+            if (!ret)
+                throw Error{};
+            spare_returns.push_back(record.get());
+            returns.push_back(std::move(record));
+            ++ c.total;
+            ++ counters.allocated;
+            return ret;
+        }
+    };
+
     struct Task {
         using handle_t = SDL_AsyncIO*;
 
@@ -180,6 +597,11 @@ namespace SDL::AsyncIO{
             auto_buffer;
         std::byte*
             buffer;
+        // set when the buffer is borrowed, it goes back there instead of delete[]
+        BufferPool*
+            pool{nullptr};
+        std::size_t
+            pooled_size{0};
 
         Task(const TaskQueue& bind_queue, const std::size_t buf_size, const handle_t handle=nullptr) noexcept:
             handle{handle},
@@ -193,6 +615,15 @@ namespace SDL::AsyncIO{
             auto_buffer{true},
             buffer{buffer.release()}{}
 
+        // buffer borrowed from the pool, at least buf_size bytes and page aligned
+        Task(const TaskQueue& bind_queue, BufferPool& pool, const std::size_t buf_size, const handle_t handle=nullptr):
+            handle{handle},
+            bind_queue{bind_queue},
+            auto_buffer{false},
+            buffer{pool.acquire(buf_size)},
+            pool{&pool},
+            pooled_size{buf_size}{}
+
         template<typename T, std::size_t N>
         Task(const TaskQueue& bind_queue, T (&buffer)[N], const handle_t handle=nullptr) noexcept:
             handle{handle},
@@ -205,15 +636,19 @@ namespace SDL::AsyncIO{
         Task& operator=(const Task& other) = delete;
 
         Task(Task&& other) noexcept:
-            bind_queue{other.bind_queue}{
-            std::swap(handle, other.handle);
-            std::swap(auto_buffer, other.auto_buffer);
-            std::swap(buffer, other.buffer);
-        }
+            handle{std::exchange(other.handle, nullptr)},
+            bind_queue{other.bind_queue},
+            auto_buffer{std::exchange(other.auto_buffer, false)},
+            buffer{std::exchange(other.buffer, nullptr)},
+            pool{std::exchange(other.pool, nullptr)},
+            pooled_size{std::exchange(other.pooled_size, 0)}{}
         Task& operator = (Task&& other) noexcept {
             std::swap(handle, other.handle);
+            std::swap(bind_queue, other.bind_queue);
             std::swap(auto_buffer, other.auto_buffer);
             std::swap(buffer, other.buffer);
+            std::swap(pool, other.pool);
+            std::swap(pooled_size, other.pooled_size);
             return *this;
         }
 
@@ -224,10 +659,16 @@ namespace SDL::AsyncIO{
             return ret;
         }
 
+        // no request may be in flight on the buffer, same for the rebinds below
         void clear() noexcept {
             if (auto_buffer)
                 delete[] buffer;
+            if (pool)
+                pool -> release(buffer, pooled_size);
             auto_buffer = false;
+            buffer = nullptr;
+            pool = nullptr;
+            pooled_size = 0;
         }
         // ReSharper disable once CppParameterMayBeConstPtrOrRef
         void rebind(TaskQueue& queue) noexcept {
@@ -246,6 +687,16 @@ namespace SDL::AsyncIO{
             auto_buffer = true;
         }
 
+        // swap the buffer for one borrowed from the pool
+        void rebind(BufferPool& pool, const std::size_t buf_size) {
+            const auto borrowed = pool.acquire(buf_size);
+            clear();
+            buffer = borrowed;
+            this -> pool = &pool;
+            pooled_size = buf_size;
+        }
+
+        // a pooled buffer can not be picked, nullptr
         [[nodiscard]]
         std::unique_ptr<std::byte[]>
             pick() noexcept {
@@ -260,20 +711,62 @@ namespace SDL::AsyncIO{
 
 
 
-        template<typename U>
+        template<typename U=void>
         bool read(Uint64 rd_offset, Uint64 rd_size, U* userdata=nullptr) noexcept {
-            return SDL_ReadAsyncIO(handle, static_cast<void*>(buffer), rd_offset, rd_size, static_cast<void*>(userdata));
+            return SDL_ReadAsyncIO(handle, static_cast<void*>(buffer), rd_offset, rd_size, bind_queue.handle, static_cast<void*>(userdata));
         }
 
-        template<typename U>
+        template<typename U=void>
         bool write(Uint64 rd_offset, Uint64 rd_size, U* userdata=nullptr) noexcept {
-            return SDL_WriteAsyncIO(handle, static_cast<void*>(buffer), rd_offset, rd_size, static_cast<void*>(userdata));
+            return SDL_WriteAsyncIO(handle, static_cast<void*>(buffer), rd_offset, rd_size, bind_queue.handle, static_cast<void*>(userdata));
+        }
+
+        // read into memory of the caller's instead of the task's buffer, e.g. a slice of it
+        template<typename U=void>
+        bool read_into(void* dst, Uint64 rd_offset, Uint64 rd_size, U* userdata=nullptr) noexcept {
+            return SDL_ReadAsyncIO(handle, dst, rd_offset, rd_size, bind_queue.handle, static_cast<void*>(userdata));
+        }
+
+
+        // write from memory of the caller's instead of the task's buffer
+        template<typename U=void>
+        bool write_from(const void* src, Uint64 wr_offset, Uint64 wr_size, U* userdata=nullptr) noexcept {
+            return SDL_WriteAsyncIO(handle, const_cast<void*>(src), wr_offset, wr_size, bind_queue.handle, static_cast<void*>(userdata));
+        }
+
+        // a batch entry for TaskQueue::submit, into / from the task's buffer unless memory is given
+        template<typename U=void>
+        Submission submission(const TaskType type, const Uint64 offset, const Uint64 size, void* memory=nullptr, U* userdata=nullptr) const noexcept {
+            return {handle, type, memory ? memory : static_cast<void*>(buffer), offset, size, static_cast<void*>(userdata)};
+        }
+
+        // co_await-able counterparts of read / read_into / write, completed through the bound queue
+        Request async_read(const Uint64 rd_offset, const Uint64 rd_size) const noexcept {
+            return {handle, bind_queue.handle, TaskType::READ, buffer, rd_offset, rd_size};
         }
 
+        Request async_read_into(void* dst, const Uint64 rd_offset, const Uint64 rd_size) const noexcept {
+            return {handle, bind_queue.handle, TaskType::READ, dst, rd_offset, rd_size};
+        }
 
+        Request async_write(const Uint64 wr_offset, const Uint64 wr_size) const noexcept {
+            return {handle, bind_queue.handle, TaskType::WRITE, buffer, wr_offset, wr_size};
+        }
+
+        /**
+         * a pooled buffer is kept until the close lands: reads still in flight may write into it until then.
+         * the close carries a Completion returning it, whoever drains the queue must dispatch it
+         * (Completion::dispatch, as Scheduler and Dispatcher do), a dropped close leaks the buffer instead.
+         */
         ~Task() noexcept {
-            if (auto_buffer)
-                delete[] buffer;
+            if (handle && pool) {
+                const auto on_closed = pool -> release_on(buffer, pooled_size);
+                // not queued, so nothing is in flight either
+                if (!SDL_CloseAsyncIO(handle, true, bind_queue.handle, on_closed) && on_closed)
+                    on_closed -> complete({});
+                return;
+            }
+            clear();
             if (handle)
                 SDL_CloseAsyncIO(handle, true, bind_queue.handle, nullptr);
         }
@@ -287,7 +780,7 @@ namespace SDL::AsyncIO{
         static handle_t fromFile(
             const std::filesystem::path& file,
             const OpenMode mode
-            ) noexcept {
+            ) {
             using enum OpenMode;
 
             handle_t ret{nullptr};
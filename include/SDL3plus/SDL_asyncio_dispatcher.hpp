@@ -0,0 +1,300 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_ASYNCIO_DISPATCHER_HPP
+#define SDL_ASYNCIO_DISPATCHER_HPP
+#include "SDL_asyncio.hpp"
+#include "SDL_cpuinfo.hpp"
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace SDL::AsyncIO {
+    /**
+     * a callable as a request's continuation, pass its address as the userdata.
+     * it must outlive the request and must not throw
+     */
+    template<typename F>
+    struct Continuation: Completion {
+        F
+            fn;
+
+        explicit Continuation(F fn):
+            Completion{call},
+            fn{std::move(fn)} {}
+
+        static void call(Completion* self, const Outcome& outcome) noexcept {
+            static_cast<Continuation*>(self) -> fn(outcome);
+        }
+    };
+
+    /**
+     * worker threads running the continuation (Completion) of every outcome of a TaskQueue.
+     *
+     * one idle worker at a time is the poller: it blocks on the queue with no timeout and takes
+     * every outcome ready at once (up to `batch`) into its own ring, then hands the role on.
+     * the other idle workers sleep on an atomic wait, the poller and post() wake them to steal:
+     * a worker runs its ring from the front while idle ones steal from the back,
+     * so a batch of heavy continuations (decompression, parsing) spreads over the cores.
+     * rings are fixed at 2 * batch, post() only fills them up to half so the poller always has room,
+     * with every ring that full the caller runs the continuation itself.
+     * outcomes without userdata (e.g. closes queued by Task destructors) are dropped.
+     *
+     * shutdown (destructor or stop()) requests stop, wakes the sleepers and signals the queue until every worker left,
+     * work already taken is finished first, outcomes still in the queue stay there.
+     */
+    struct Dispatcher {
+        // fixed capacity deque, guarded by its worker's lock
+        struct Ring {
+            std::unique_ptr<Outcome[]>
+                slots;
+            std::size_t
+                mask;
+            std::size_t
+                head{0};
+            std::size_t
+                tail{0};
+
+            explicit Ring(const std::size_t capacity):
+                slots{std::make_unique<Outcome[]>(std::bit_ceil(capacity))},
+                mask{std::bit_ceil(capacity) - 1} {}
+
+            std::size_t size() const noexcept {
+                return tail - head;
+            }
+
+            void push_back(const Outcome& outcome) noexcept {
+                slots[tail ++ & mask] = outcome;
+            }
+
+            Outcome pop_front() noexcept {
+                return slots[head ++ & mask];
+            }
+
+            Outcome pop_back() noexcept {
+                return slots[-- tail & mask];
+            }
+        };
+
+        struct alignas(cacheline_size) Worker {
+            Ring
+                local;
+            std::mutex
+                lock;
+            std::atomic<Uint64>
+                dispatched{0};
+            std::atomic<Uint64>
+                stolen{0};
+
+            explicit Worker(const std::size_t capacity):
+                local{capacity} {}
+        };
+
+        struct Stats {
+            Uint64
+                dispatched;
+            Uint64
+                stolen;
+        };
+
+        TaskQueue
+            queue;
+        std::size_t
+            batch;
+        std::size_t
+            capacity;
+        std::vector<std::unique_ptr<Worker>>
+            workers;
+        std::atomic_bool
+            polling{false};
+        // bumped after work is pushed or the poller role is freed, idle workers wait on it
+        std::atomic<Uint32>
+            epoch{0};
+        std::atomic_size_t
+            running{0};
+        // round robin target of post()
+        std::atomic_size_t
+            next_post{0};
+        // destroyed first, the destructor has stopped them by then
+        std::vector<std::jthread>
+            threads;
+
+        // threads=0 takes one per logical core
+        explicit Dispatcher(const TaskQueue& queue, std::size_t threads=0, const std::size_t batch=16):
+            queue{queue},
+            batch{SDL::max<std::size_t>(batch, 1)},
+            capacity{std::bit_ceil(this->batch * 2)} {
+            if (threads == 0)
+                threads = static_cast<std::size_t>(SDL::max(logical_cores(), 1));
+            workers.reserve(threads);
+            for (std::size_t i = 0; i < threads; ++ i)
+                workers.push_back(std::make_unique<Worker>(capacity));
+
+            this -> threads.reserve(threads);
+            try {
+                for (std::size_t i = 0; i < threads; ++ i) {
+                    ++ running;
+                    this -> threads.emplace_back([this, i](const std::stop_token& token) noexcept {
+                        work(i, token);
+                        -- running;
+                    });
+                }
+            }
+            catch (...) {
+                -- running;
+                stop();
+                throw;
+            }
+        }
+
+        Dispatcher(const Dispatcher&)=delete;
+        Dispatcher& operator = (const Dispatcher&)=delete;
+
+        ~Dispatcher() noexcept {
+            stop();
+        }
+
+        // returns once every worker left, a worker running a continuation finishes it first
+        void stop() noexcept {
+            for (auto& thread: threads)
+                thread.request_stop();
+            // the poller may be between its stop check and the wait and miss a signal, repeat until all are out
+            while (running.load(std::memory_order_acquire) > 0) {
+                wake(true);
+                queue.signal();
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            threads.clear();
+        }
+
+        /**
+         * runs an outcome on the pool as if it came from the queue, e.g. to split one continuation's work.
+         * runs it on the calling thread when every ring is half full,
+         * or when the only worker is the poller (it would not look before the next outcome lands)
+         */
+        void post(const Outcome& outcome) {
+            const auto first = next_post.fetch_add(1, std::memory_order_relaxed);
+            for (std::size_t k = 0; k < workers.size(); ++ k) {
+                auto& worker = *workers[(first + k) % workers.size()];
+                {
+                    auto guard = std::scoped_lock{worker.lock};
+                    if (worker.local.size() + batch >= capacity)
+                        continue;
+                    worker.local.push_back(outcome);
+                }
+                // pushed before looking, pairs with the poller's look after taking the role
+                if (workers.size() == 1 && polling.load()) {
+                    Outcome back;
+                    if (pop_back(worker, back))
+                        Completion::dispatch(back);
+                    return;
+                }
+                wake(false);
+                return;
+            }
+            Completion::dispatch(outcome);
+        }
+
+        Stats stats() const noexcept {
+            Stats ret{0, 0};
+            for (const auto& worker: workers) {
+                ret.dispatched += worker -> dispatched.load(std::memory_order_relaxed);
+                ret.stolen += worker -> stolen.load(std::memory_order_relaxed);
+            }
+            return ret;
+        }
+
+        void wake(const bool all) noexcept {
+            epoch.fetch_add(1, std::memory_order_release);
+            if (all)
+                epoch.notify_all();
+            else
+                epoch.notify_one();
+        }
+
+        bool pop(Worker& worker, Outcome& outcome) noexcept {
+            auto guard = std::scoped_lock{worker.lock};
+            if (worker.local.size() == 0)
+                return false;
+            outcome = worker.local.pop_front();
+            return true;
+        }
+
+        bool pop_back(Worker& worker, Outcome& outcome) noexcept {
+            auto guard = std::scoped_lock{worker.lock};
+            if (worker.local.size() == 0)
+                return false;
+            outcome = worker.local.pop_back();
+            return true;
+        }
+
+        bool steal(const std::size_t self, Outcome& outcome) noexcept {
+            for (std::size_t k = 1; k < workers.size(); ++ k)
+                if (pop_back(*workers[(self + k) % workers.size()], outcome))
+                    return true;
+            return false;
+        }
+
+        void work(const std::size_t self, const std::stop_token& token) noexcept {
+            auto& worker = *workers[self];
+            auto taken = std::make_unique<Outcome[]>(batch);
+            Outcome outcome;
+            const auto run = [&] {
+                if (pop(worker, outcome)) {
+                    worker.dispatched.fetch_add(Completion::dispatch(outcome), std::memory_order_relaxed);
+                    return true;
+                }
+                if (steal(self, outcome)) {
+                    worker.stolen.fetch_add(1, std::memory_order_relaxed);
+                    worker.dispatched.fetch_add(Completion::dispatch(outcome), std::memory_order_relaxed);
+                    return true;
+                }
+                return false;
+            };
+
+            for (;;) {
+                // read before the last look: work pushed after it bumps the epoch and the wait returns
+                const auto seen = epoch.load(std::memory_order_acquire);
+                if (run())
+                    continue;
+                if (token.stop_requested())
+                    return;
+
+                if (polling.exchange(true)) {
+                    epoch.wait(seen, std::memory_order_acquire);
+                    continue;
+                }
+                // look again holding the role, a post() that saw no poller has pushed by now
+                bool stolen = false;
+                if (pop(worker, outcome) || (stolen = steal(self, outcome))) {
+                    polling.store(false);
+                    wake(false);
+                    worker.stolen.fetch_add(stolen, std::memory_order_relaxed);
+                    worker.dispatched.fetch_add(Completion::dispatch(outcome), std::memory_order_relaxed);
+                    continue;
+                }
+
+                // the poller, post() only fills rings up to capacity - batch, so the whole batch fits
+                const auto n = queue.drain({taken.get(), batch}, std::chrono::milliseconds{-1});
+                {
+                    auto guard = std::scoped_lock{worker.lock};
+                    for (std::size_t i = 0; i < n; ++ i)
+                        worker.local.push_back(taken[i]);
+                }
+                polling.store(false, std::memory_order_release);
+                // one takes over polling, with more than one outcome the rest come to steal
+                if (n > 0)
+                    wake(n > 1);
+            }
+        }
+    };
+}
+
+#endif //SDL_ASYNCIO_DISPATCHER_HPP
@@ -0,0 +1,259 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_ASYNCIO_JOB_HPP
+#define SDL_ASYNCIO_JOB_HPP
+#include "SDL_asyncio.hpp"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace SDL::AsyncIO {
+    namespace job {
+        template<typename T>
+        struct Value {
+            std::optional<T>
+                value;
+
+            template<typename U>
+            void return_value(U&& v) {
+                value.emplace(std::forward<U>(v));
+            }
+
+            T take() {
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Value<void> {
+            static void return_void() noexcept {}
+            static void take() noexcept {}
+        };
+
+        /**
+         * hands control back to whoever awaited the job, or to nobody.
+         * the job may finish on another thread (e.g. a Dispatcher worker) while it is being awaited,
+         * so the awaiter and the job trade the continuation slot with an exchange:
+         * the job leaves its promise's address there, the awaiter its handle, the later one resumes the awaiter
+         */
+        struct Final {
+            static bool await_ready() noexcept {
+                return false;
+            }
+
+            template<typename P>
+            static std::coroutine_handle<> await_suspend(const std::coroutine_handle<P> h) noexcept {
+                auto& promise = h.promise();
+                if (const auto awaiter = promise.continuation.exchange(&promise, std::memory_order_acq_rel))
+                    return std::coroutine_handle<>::from_address(awaiter);
+                return std::noop_coroutine();
+            }
+
+            static void await_resume() noexcept {}
+        };
+    }
+
+    /**
+     * coroutine returned by loading code that co_awaits Requests and other Jobs.
+     *
+     * lazy: it starts when awaited, on start(), or in Scheduler::run. an awaited job
+     * resumes its awaiter when it finishes, exceptions travel to the awaiter / result().
+     * the frame belongs to the Job and must not be destroyed while it waits for an outcome.
+     * start(), co_await and result() belong to one thread, the job itself may be resumed on any.
+     */
+    template<typename T=void>
+    struct Job {
+        struct promise_type: job::Value<T> {
+            // the awaiter's handle address, or this promise once finished (job::Final)
+            std::atomic<void*>
+                continuation{nullptr};
+            std::exception_ptr
+                error;
+            bool
+                started{false};
+
+            Job get_return_object() noexcept {
+                return Job{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            static std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            static job::Final final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() noexcept {
+                error = std::current_exception();
+            }
+        };
+
+        using handle_t = std::coroutine_handle<promise_type>;
+
+        handle_t
+            handle{};
+
+        Job() noexcept=default;
+        explicit Job(const handle_t handle) noexcept:
+            handle{handle} {}
+
+        Job(const Job&)=delete;
+        Job& operator = (const Job&)=delete;
+
+        Job(Job&& other) noexcept:
+            handle{std::exchange(other.handle, {})} {}
+
+        Job& operator = (Job&& other) noexcept {
+            std::swap(handle, other.handle);
+            return *this;
+        }
+
+        ~Job() noexcept {
+            if (handle)
+                handle.destroy();
+        }
+
+        // past job::Final, reads the slot it set instead of the frame so a job finishing on another thread is seen with its result
+        bool done() const noexcept {
+            return !handle || handle.promise().continuation.load(std::memory_order_acquire) == &handle.promise();
+        }
+
+        // runs the job up to its first suspension, no-op once started
+        void start() noexcept {
+            if (handle && !handle.promise().started) {
+                handle.promise().started = true;
+                handle.resume();
+            }
+        }
+
+        // the co_return value of a finished job, or its exception
+        T result() {
+            if (!handle || !done()) {
+                SDL_SetError("result of a job that has not finished");
+                throw Error{};
+            }
+            if (handle.promise().error)
+                std::rethrow_exception(handle.promise().error);
+            return handle.promise().take();
+        }
+
+        /**
+         * both awaiters suspend h on the job through this: starts it, or parks h in the continuation slot.
+         * started earlier and maybe running elsewhere, it may already have finished and left its promise
+         * in the slot, which then stays there (done() reads it) and h carries on
+         */
+        std::coroutine_handle<> suspend(const std::coroutine_handle<> h) noexcept {
+            auto& promise = handle.promise();
+            if (!promise.started) {
+                promise.started = true;
+                promise.continuation.store(h.address(), std::memory_order_relaxed);
+                return handle;
+            }
+            void* expected = nullptr;
+            if (!promise.continuation.compare_exchange_strong(expected, h.address(), std::memory_order_acq_rel, std::memory_order_acquire))
+                return h;
+            return std::noop_coroutine();
+        }
+
+        auto operator co_await () & noexcept {
+            struct Awaiter {
+                Job&
+                    job;
+
+                bool await_ready() const noexcept {
+                    return job.done();
+                }
+
+                std::coroutine_handle<> await_suspend(const std::coroutine_handle<> h) noexcept {
+                    return job.suspend(h);
+                }
+
+                T await_resume() {
+                    return job.result();
+                }
+            };
+            return Awaiter{*this};
+        }
+
+        // co_await load(...) on a temporary, kept alive by the awaiter in the caller's frame
+        auto operator co_await () && noexcept {
+            struct Awaiter {
+                Job
+                    job;
+
+                bool await_ready() const noexcept {
+                    return job.done();
+                }
+
+                std::coroutine_handle<> await_suspend(const std::coroutine_handle<> h) noexcept {
+                    return job.suspend(h);
+                }
+
+                T await_resume() {
+                    return job.result();
+                }
+            };
+            return Awaiter{std::move(*this)};
+        }
+    };
+
+    /**
+     * drains a TaskQueue and resumes the coroutine owning each outcome (Completion::dispatch),
+     * coroutines run on the thread calling poll / run. every request on the queue must carry
+     * a Completion or no userdata, which is the case for Task::async_* and TaskQueue::async_load.
+     */
+    struct Scheduler {
+        TaskQueue
+            queue;
+
+        explicit Scheduler(const TaskQueue& queue) noexcept:
+            queue{queue} {}
+
+        // dispatches every outcome already there, without waiting, returns how many
+        std::size_t poll() noexcept {
+            std::size_t ret = 0;
+            Outcome batch[32];
+            for (std::size_t n; (n = queue.drain(batch)) > 0;)
+                for (std::size_t i = 0; i < n; ++ i)
+                    ret += Completion::dispatch(batch[i]);
+            return ret;
+        }
+
+        // waits up to timeout for an outcome, then dispatches the rest already there
+        std::size_t run_one(const std::chrono::milliseconds timeout) noexcept {
+            Outcome outcome;
+            if (!queue.wait(outcome, timeout))
+                return 0;
+            return Completion::dispatch(outcome) + poll();
+        }
+
+        // dispatches until done() holds, queue.signal() makes it check early
+        template<typename Done>
+        void run_until(Done&& done) {
+            Outcome outcome;
+            while (!done())
+                if (queue.wait(outcome))
+                    Completion::dispatch(outcome);
+        }
+
+        template<typename T>
+        T run(Job<T>& job) {
+            job.start();
+            run_until([&job] { return job.done(); });
+            return job.result();
+        }
+
+        template<typename T>
+        T run(Job<T>&& job) {
+            return run(job);
+        }
+    };
+}
+
+#endif //SDL_ASYNCIO_JOB_HPP
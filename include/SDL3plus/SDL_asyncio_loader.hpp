@@ -0,0 +1,212 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_ASYNCIO_LOADER_HPP
+#define SDL_ASYNCIO_LOADER_HPP
+#include "SDL_asyncio.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace SDL::AsyncIO {
+    /**
+     * reads one large file with many ranged reads in flight at once, instead of LoadFileAsync's single request.
+     *
+     * the file is opened once, split in chunk_size pieces and up to depth of them are read
+     * concurrently straight into the destination, each landed chunk is replaced by the next one,
+     * a short read resubmits its remainder. poll() / wait() drive it from one thread,
+     * loaded() / progress() / done() may be read from any.
+     * the destination is either owned (take() hands it over) or the caller's, at least size() bytes.
+     */
+    struct RangedLoader {
+        struct Chunk {
+            Uint64
+                offset{0};
+            Uint64
+                size{0};
+        };
+
+        // every chunk read and the file's final close complete here, so it must be destroyed after `file`
+        TaskQueue
+            queue;
+        Task
+            file;
+        Uint64
+            total;
+        std::unique_ptr<std::byte[]>
+            owned;
+        std::byte*
+            destination;
+        Uint64
+            chunk_size;
+
+        // polling thread from here
+        std::vector<Chunk>
+            chunks;
+        Uint64
+            cursor{0};
+        std::size_t
+            in_flight{0};
+
+        std::atomic<Uint64>
+            loaded_bytes{0};
+        std::atomic_bool
+            failure{false};
+
+        explicit RangedLoader(const std::filesystem::path& path, const Uint64 chunk_size=1 << 20, const std::size_t depth=16):
+            file{queue, std::size_t{0}, Task::fromFile(path, Task::OpenMode::READ)},
+            total{static_cast<Uint64>(file.size())},
+            owned{new std::byte[total]},
+            destination{owned.get()},
+            chunk_size{SDL::max<Uint64>(chunk_size, 1)},
+            chunks(SDL::max<std::size_t>(depth, 1)) {
+            start();
+        }
+
+        // into the caller's memory, which must hold size() bytes and outlive the loader
+        RangedLoader(const std::filesystem::path& path, const std::span<std::byte> destination, const Uint64 chunk_size=1 << 20, const std::size_t depth=16):
+            file{queue, std::size_t{0}, Task::fromFile(path, Task::OpenMode::READ)},
+            total{static_cast<Uint64>(file.size())},
+            destination{destination.data()},
+            chunk_size{SDL::max<Uint64>(chunk_size, 1)},
+            chunks(SDL::max<std::size_t>(depth, 1)) {
+            if (destination.size() < total) {
+                SDL_SetError("destination of %zu bytes can not hold a file of %llu", destination.size(), static_cast<unsigned long long>(total));
+                throw Error{};
+            }
+            start();
+        }
+
+        RangedLoader(const RangedLoader&)=delete;
+        RangedLoader& operator = (const RangedLoader&)=delete;
+
+        // chunk reads still in flight target `destination` and the Chunk slots, both die with the loader,
+        // so collect every one of them first, even after a failure stopped new reads
+        ~RangedLoader() noexcept {
+            Outcome outcome;
+            while (in_flight > 0 && queue.wait(outcome))
+                if (outcome.type == TaskType::CLOSE)
+                    Completion::dispatch(outcome);
+                else
+                    -- in_flight;
+        }
+
+        Uint64 size() const noexcept {
+            return total;
+        }
+
+        Uint64 loaded() const noexcept {
+            return loaded_bytes.load(std::memory_order_acquire);
+        }
+
+        // 0 to 1, an empty file counts as loaded
+        double progress() const noexcept {
+            return total == 0 ? 1.0 : static_cast<double>(loaded()) / static_cast<double>(total);
+        }
+
+        bool failed() const noexcept {
+            return failure.load(std::memory_order_acquire);
+        }
+
+        bool done() const noexcept {
+            return failed() || loaded() == total;
+        }
+
+        // valid once done() without failed()
+        std::span<std::byte> data() const noexcept {
+            return {destination, static_cast<std::size_t>(total)};
+        }
+
+        // the owned destination, nullptr when loading into the caller's memory
+        [[nodiscard]]
+        std::unique_ptr<std::byte[]> take() noexcept {
+            return std::move(owned);
+        }
+
+        // handles every landed chunk and tops the reads back up, never waits. returns done()
+        bool poll() noexcept {
+            Outcome batch[32];
+            for (std::size_t n; (n = queue.drain(batch)) > 0;)
+                for (std::size_t i = 0; i < n; ++ i)
+                    land(batch[i]);
+            return done();
+        }
+
+        // blocks until every chunk landed or one failed, false on failure
+        bool wait() noexcept {
+            Outcome outcome;
+            while (!done() && in_flight > 0)
+                if (queue.wait(outcome))
+                    land(outcome);
+            return !failed();
+        }
+
+        // same, giving up after timeout, returns done()
+        bool wait(const std::chrono::milliseconds timeout) noexcept {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            Outcome outcome;
+            while (!done() && in_flight > 0) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (left.count() <= 0 || !queue.wait(outcome, left))
+                    break;
+                land(outcome);
+                poll();
+            }
+            return done();
+        }
+
+        void start() noexcept {
+            for (auto& chunk: chunks)
+                next(chunk);
+        }
+
+        // the next range of the file into this chunk slot, if any is left
+        void next(Chunk& chunk) noexcept {
+            if (cursor == total || failed())
+                return;
+            chunk.offset = cursor;
+            chunk.size = SDL::min(chunk_size, total - cursor);
+            cursor += chunk.size;
+            submit(chunk);
+        }
+
+        void submit(Chunk& chunk) noexcept {
+            if (!file.read_into(destination + chunk.offset, chunk.offset, chunk.size, &chunk)) {
+                failure = true;
+                return;
+            }
+            ++ in_flight;
+        }
+
+        void land(const Outcome& outcome) noexcept {
+            // a close carries no chunk
+            if (outcome.type == TaskType::CLOSE) {
+                Completion::dispatch(outcome);
+                return;
+            }
+            const auto chunk = outcome.userdata<Chunk>();
+            -- in_flight;
+
+            const auto got = SDL::min(outcome.bytes_transferred, chunk -> size);
+            if (outcome.result != Result::COMPLETE || got == 0) {
+                failure.store(true, std::memory_order_release);
+                return;
+            }
+            loaded_bytes.fetch_add(got, std::memory_order_acq_rel);
+
+            if (got < chunk -> size) {
+                chunk -> offset += got;
+                chunk -> size -= got;
+                submit(*chunk);
+            }
+            else
+                next(*chunk);
+        }
+    };
+}
+
+#endif //SDL_ASYNCIO_LOADER_HPP
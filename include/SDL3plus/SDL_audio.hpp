@@ -12,14 +12,16 @@
 #include "SDL_mutex.hpp"
 #include "SDL_properties.hpp"
 #include "SDL_iostream.hpp"
+#include <new>
 #include <ranges>
+#include <vector>
 
 namespace SDL{
     namespace audio_mask {
         constexpr auto size         =  SDL_AUDIO_MASK_BITSIZE;
         constexpr auto floating     =  SDL_AUDIO_MASK_FLOAT;
         constexpr auto big_endian   =  SDL_AUDIO_MASK_BIG_ENDIAN;
-        constexpr auto with_sign    =  SDL_AUDIO_MASK_BITSIZE;
+        constexpr auto with_sign    =  SDL_AUDIO_MASK_SIGNED;
     }
 
 
@@ -74,7 +76,7 @@ namespace SDL{
     }
 
     constexpr bool is_signed(const AudioFormat x) {
-        return static_cast<Uint16>(x) & SDL_AUDIO_MASK_BITSIZE;
+        return static_cast<Uint16>(x) & SDL_AUDIO_MASK_SIGNED;
     }
 
     enum class AudioDeviceID: Uint32{};
@@ -114,6 +116,8 @@ namespace SDL{
             return bytesize(format) * channels;
         }
 
+        constexpr bool operator == (const AudioSpec& other) const noexcept=default;
+
         auto legacy_addr() const noexcept {
             return reinterpret_cast<const SDL_AudioSpec*>(this);
         }
@@ -144,6 +148,25 @@ namespace SDL{
         handle_t
             handle;
 
+        // inline storage for callables bound by the template add_callback_get / add_callback_put
+        static constexpr std::size_t callback_capacity = 8 * sizeof(void*);
+        struct CallbackSlot {
+            alignas(std::max_align_t) std::byte
+                storage[callback_capacity];
+            void (*destroy)(void*) noexcept
+                {nullptr};
+
+            void reset() noexcept {
+                if (destroy)
+                    destroy(storage);
+                destroy = nullptr;
+            }
+        };
+        CallbackSlot
+            get_slot;
+        CallbackSlot
+            put_slot;
+
         explicit AudioStream(handle_t handle):
             handle{handle} {
             if (!handle)
@@ -245,19 +268,19 @@ namespace SDL{
                 throw Error{};
         }
         int get(std::span<unsigned char> data) {
-            if (const auto sz = SDL_GetAudioStreamData(handle, data.data(),data.size()) < 0)
+            if (const auto sz = SDL_GetAudioStreamData(handle, data.data(),data.size()); sz < 0)
                 throw Error{};
             else
                 return sz;
         }
         int avaliable() const  {
-            if (const auto ret = SDL_GetAudioStreamAvailable(handle) < 0)
+            if (const auto ret = SDL_GetAudioStreamAvailable(handle); ret < 0)
                 throw Error{};
             else
                 return ret;
         }
         int queued() const  {
-            if (const auto ret = SDL_GetAudioStreamQueued(handle) < 0)
+            if (const auto ret = SDL_GetAudioStreamQueued(handle); ret < 0)
                 throw Error{};
             else
                 return ret;
@@ -297,29 +320,130 @@ namespace SDL{
         void add_callback_get(Callback callback, void* data) {
             if (!SDL_SetAudioStreamGetCallback(handle, callback, data))
                 throw Error{};
+            get_slot.reset();
         }
 
         void add_callback_put(Callback callback, void* data) {
             if (!SDL_SetAudioStreamPutCallback(handle, callback, data))
                 throw Error{};
+            put_slot.reset();
+        }
+
+        /**
+         * bind any callable `void(AudioStream&, int additional_amount, int total_amount)`.
+         * the callable is stored inside this object (up to callback_capacity bytes)
+         * and called through a trampoline generated for its type,
+         * no heap allocation and no type erasure on the audio thread.
+         * it lives until it is replaced or the stream is destroyed.
+         */
+        template<typename F>
+        requires std::invocable<std::decay_t<F>&, AudioStream&, int, int>
+        void add_callback_get(F&& callback) {
+            bind_callback<SDL_SetAudioStreamGetCallback, &AudioStream::get_slot>(std::forward<F>(callback));
+        }
+
+        template<typename F>
+        requires std::invocable<std::decay_t<F>&, AudioStream&, int, int>
+        void add_callback_put(F&& callback) {
+            bind_callback<SDL_SetAudioStreamPutCallback, &AudioStream::put_slot>(std::forward<F>(callback));
+        }
+
+        template<typename T, CallbackSlot AudioStream::* slot>
+        static void SDLCALL trampoline(void* userdata, SDL_AudioStream*, const int additional_amount, const int total_amount) noexcept {
+            auto& self = *static_cast<AudioStream*>(userdata);
+            (*std::launder(reinterpret_cast<T*>((self.*slot).storage)))(self, additional_amount, total_amount);
+        }
+
+        template<auto setter, CallbackSlot AudioStream::* slot, typename F>
+        void bind_callback(F&& callback) {
+            using T = std::decay_t<F>;
+            static_assert(sizeof(T) <= callback_capacity, "callable too large to be stored inline, capture a pointer instead");
+            static_assert(alignof(T) <= alignof(std::max_align_t));
+            static_assert(std::is_nothrow_destructible_v<T>);
+
+            // detach first, SDL takes the stream lock so no callback is running afterward
+            if (!setter(handle, nullptr, nullptr))
+                throw Error{};
+            (this->*slot).reset();
+
+            new ((this->*slot).storage) T(std::forward<F>(callback));
+            (this->*slot).destroy = [](void* p) noexcept {
+                static_cast<T*>(p) -> ~T();
+            };
+
+            if (!setter(handle, trampoline<T, slot>, this)) {
+                (this->*slot).reset();
+                throw Error{};
+            }
         }
 
+        // callables bound above point back to this object, so it can not be copied around
+        AudioStream(const AudioStream&)=delete;
+        AudioStream& operator = (const AudioStream&)=delete;
+
         ~AudioStream() noexcept{
             SDL_DestroyAudioStream(handle);
-        }
+            get_slot.reset();
+            put_slot.reset();
+        }
+
+        // handles of a range of streams: on the stack up to inline_handles, one heap block above
+        static constexpr std::size_t inline_handles = 64;
+
+        struct Handles {
+            handle_t
+                local[inline_handles];
+            std::vector<handle_t>
+                spill{};
+            std::size_t
+                count{0};
+
+            template<std::ranges::range Range>
+            explicit Handles(const Range& streams) {
+                if constexpr (std::ranges::sized_range<const Range>)
+                    if (const auto n = static_cast<std::size_t>(std::ranges::size(streams)); n > inline_handles)
+                        spill.reserve(n);
+                for (AudioStream& e: streams)
+                    push(e.handle);
+            }
+
+            void push(const handle_t h) {
+                if (count < inline_handles && spill.empty()) {
+                    local[count++] = h;
+                    return;
+                }
+                if (spill.empty())
+                    spill.assign(local, local + count);
+                spill.push_back(h);
+                ++ count;
+            }
+
+            const handle_t* data() const noexcept {
+                return spill.empty() ? local : spill.data();
+            }
+
+            int size() const noexcept {
+                return static_cast<int>(count);
+            }
+        };
 
         template<std::ranges::range Range>
-        static void unbind(const Range& streams){
-            auto cache = std::vector<SDL_AudioStream*>{};
-            for (AudioStream& e: streams)
-                cache.emplace_back(e.handle);
-
-            SDL_UnbindAudioStreams(cache.data(), cache.size());
+        requires std::convertible_to<std::ranges::range_reference_t<const Range>, AudioStream&>
+        static void unbind(const Range& streams) {
+            const auto handles = Handles{streams};
+            SDL_UnbindAudioStreams(handles.data(), handles.size());
         }
 
+        static void unbind(const std::span<const handle_t> handles) noexcept {
+            SDL_UnbindAudioStreams(handles.data(), static_cast<int>(handles.size()));
+        }
 
+        // one SDL call for the whole range, so every stream starts on the same device buffer
         template<std::ranges::range Range>
+        requires std::convertible_to<std::ranges::range_reference_t<const Range>, AudioStream&>
         static void bind(const AudioDevice& device, const Range& streams);
+
+        static void bind(const AudioDevice& device, std::span<const handle_t> handles);
     };
 
 
@@ -330,13 +454,13 @@ namespace SDL{
         // this id will NOT promise to be the member
         // return value of SDL_OpenAudioDevice will be used
         AudioDevice(AudioDeviceID id, const AudioSpec& spec):
-            id{SDL_OpenAudioDevice(legacy_id(), reinterpret_cast<const SDL_AudioSpec*>(&spec))}{
+            id{SDL_OpenAudioDevice(legacy(id), reinterpret_cast<const SDL_AudioSpec*>(&spec))}{
             if (static_cast<Uint32>(id) == 0)
                 throw Error{};
         }
 
         explicit AudioDevice(AudioDeviceID id):
-            id{SDL_OpenAudioDevice(legacy_id(), nullptr)}{
+            id{SDL_OpenAudioDevice(legacy(id), nullptr)}{
             if (static_cast<Uint32>(id) == 0)
                 throw Error{};
         }
@@ -455,6 +579,26 @@ namespace SDL{
                 throw Error{};
         }
 
+        /**
+         * bind any callable `void(const AudioSpec&, std::span<float>)` through a generated trampoline.
+         * AudioDevice has to stay the same size as AudioDeviceID (device lists are reinterpreted),
+         * so the callable is NOT stored here: it is referenced, and must outlive the binding.
+         */
+        template<typename F>
+        requires std::invocable<F&, const AudioSpec&, std::span<float>>
+        void setAudioPostmixCallback(F& callback) {
+            setAudioPostmixCallback(postmix_trampoline<F>, static_cast<void*>(std::addressof(callback)));
+        }
+
+        // runs inside SDL's C frames, an exception escaping the callable terminates instead of unwinding through them
+        template<typename F>
+        static void SDLCALL postmix_trampoline(void* userdata, const SDL_AudioSpec* spec, float* buffer, const int buflen) noexcept {
+            (*static_cast<F*>(userdata))(AudioSpec{*spec}, std::span{buffer, static_cast<std::size_t>(buflen) / sizeof(float)});
+        }
+
+        template<typename F>
+        void setAudioPostmixCallback(F&& callback) = delete;
+
         [[nodiscard]]
         static List<AudioDevice>
             recording_devices()  {
@@ -472,12 +616,15 @@ namespace SDL{
     }
 
     template<std::ranges::range Range>
+    requires std::convertible_to<std::ranges::range_reference_t<const Range>, AudioStream&>
     void AudioStream::bind(const AudioDevice& device, const Range& streams) {
-        auto cache = std::vector<SDL_AudioStream*>{};
-        for (AudioStream& e: streams)
-            cache.emplace_back(e.handle);
+        const auto handles = Handles{streams};
+        if (!SDL_BindAudioStreams(device.legacy_id(), handles.data(), handles.size()))
+            throw Error{};
+    }
 
-        if (!SDL_BindAudioStreams(device.legacy_id(), cache.data(), cache.size()))
+    inline void AudioStream::bind(const AudioDevice& device, std::span<const handle_t> handles) {
+        if (!SDL_BindAudioStreams(device.legacy_id(), handles.data(), static_cast<int>(handles.size())))
             throw Error{};
     }
 
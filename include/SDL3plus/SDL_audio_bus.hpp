@@ -0,0 +1,298 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_BUS_HPP
+#define SDL_AUDIO_BUS_HPP
+#include "SDL_audio.hpp"
+#include "SDL_audio_mixer.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace SDL {
+    enum class BusID: int {};
+    constexpr auto master_bus = BusID{0};
+
+    /**
+     * submix graph running inside the device's postmix callback.
+     *
+     * streams routed here are NOT bound to the device, the graph pulls them with
+     * SDL_GetAudioStreamData once per block, in the graph's spec (F32, device channels and rate).
+     * every bus sums its streams and child buses, runs its effects and gain once,
+     * then adds itself to its parent. buses are visited children first,
+     * so the whole graph is one pass per block, and the master bus is added on top of
+     * whatever the device mixed from directly bound streams.
+     *
+     * edits change the bus list under a mutex, then build an immutable Plan (routing, gains, buffers)
+     * and publish it through an atomic pointer. the audio thread never locks and never allocates:
+     * it marks the plan it mixes from in `in_use`, and replaced plans are freed by later edits
+     * once the audio thread moved on. unroute() waits for that, the stream may die right after.
+     * the graph and the device must outlive each other's binding.
+     * effects run on the audio thread and must not throw.
+     */
+    struct BusGraph {
+        using Effect = std::function<void(const AudioSpec&, std::span<float>)>;
+
+        struct Bus {
+            BusID
+                parent{master_bus};
+            float
+                gain{1.0f};
+            std::vector<AudioStream*>
+                inputs{};
+            // shared by every plan mixing them, a stateful effect keeps its state across edits
+            std::vector<std::shared_ptr<Effect>>
+                effects{};
+        };
+
+        // what one block is mixed from, never changed once published
+        struct Plan {
+            std::vector<Bus>
+                buses;
+            // children before parents, master last
+            std::vector<int>
+                order;
+            std::size_t
+                samples;
+            // one block of `samples` per bus
+            std::vector<float>
+                buffers;
+
+            float* buffer(const std::size_t bus) noexcept {
+                return buffers.data() + bus * samples;
+            }
+        };
+
+        // block size assumed when the device does not report one
+        static constexpr int fallback_frames = 1024;
+
+        AudioDevice&
+            device;
+        AudioSpec
+            spec;
+        // largest slice mixed at once, a bigger block is mixed in several
+        std::size_t
+            samples;
+
+        // edit side, under lock
+        std::vector<Bus>
+            buses;
+        std::vector<int>
+            order;
+        std::unique_ptr<Plan>
+            published;
+        // replaced plans the audio thread may still be reading
+        std::vector<std::unique_ptr<Plan>>
+            retired;
+        std::mutex
+            lock;
+
+        // audio thread only
+        std::vector<float>
+            scratch;
+
+        std::atomic<Plan*>
+            current{nullptr};
+        std::atomic<Plan*>
+            in_use{nullptr};
+
+        explicit BusGraph(AudioDevice& device):
+            device{device} {
+            const auto [device_spec, frames] = device.format();
+            spec = AudioSpec{AudioFormat::F32, device_spec.channels, device_spec.freq};
+            samples = static_cast<std::size_t>(frames > 0 ? frames : fallback_frames) * spec.channels;
+            scratch.resize(samples);
+
+            buses.push_back(Bus{});
+            order = {0};
+            publish();
+
+            device.setAudioPostmixCallback(*this);
+        }
+
+        BusGraph(const BusGraph&)=delete;
+        BusGraph& operator = (const BusGraph&)=delete;
+
+        // once the callback is gone no plan is in use, they all go with the graph
+        ~BusGraph() noexcept {
+            SDL_SetAudioPostmixCallback(device.legacy_id(), nullptr, nullptr);
+        }
+
+        BusID add_bus(const BusID parent=master_bus) {
+            auto guard = std::scoped_lock{lock};
+            check(parent);
+            buses.push_back(Bus{parent});
+            sort();
+            publish();
+            return static_cast<BusID>(buses.size() - 1);
+        }
+
+        void reparent(const BusID bus, const BusID parent) {
+            auto guard = std::scoped_lock{lock};
+            check(bus);
+            check(parent);
+            if (bus == master_bus) {
+                SDL_SetError("master bus has no parent");
+                throw Error{};
+            }
+            for (auto p = parent; p != master_bus; p = at(p).parent)
+                if (p == bus) {
+                    SDL_SetError("bus %d can not be routed into its own child", static_cast<int>(bus));
+                    throw Error{};
+                }
+            at(bus).parent = parent;
+            sort();
+            publish();
+        }
+
+        void gain(const BusID bus, const float v) {
+            auto guard = std::scoped_lock{lock};
+            check(bus);
+            at(bus).gain = v;
+            publish();
+        }
+
+        void add_effect(const BusID bus, Effect effect) {
+            auto guard = std::scoped_lock{lock};
+            check(bus);
+            at(bus).effects.push_back(std::make_shared<Effect>(std::move(effect)));
+            publish();
+        }
+
+        void clear_effects(const BusID bus) {
+            auto guard = std::scoped_lock{lock};
+            check(bus);
+            at(bus).effects.clear();
+            publish();
+        }
+
+        /**
+         * route a stream into a bus, its output format is switched to the graph's spec.
+         * the stream must not be bound to a device and must be unrouted before it dies
+         */
+        void route(AudioStream& stream, const BusID bus) {
+            auto guard = std::scoped_lock{lock};
+            check(bus);
+            stream.set_format(stream.format().first, spec);
+            detach(stream);
+            at(bus).inputs.push_back(&stream);
+            publish();
+        }
+
+        // returns once the audio thread no longer reads the stream
+        void unroute(AudioStream& stream) {
+            auto guard = std::scoped_lock{lock};
+            detach(stream);
+            publish();
+            while (!retired.empty()) {
+                std::this_thread::yield();
+                collect();
+            }
+        }
+
+        // audio thread, called by SDL as the postmix callback
+        void operator () (const AudioSpec& block_spec, const std::span<float> out) noexcept {
+            if (block_spec.channels != spec.channels)
+                return;
+
+            // announce the plan before trusting it, an edit retiring it meanwhile is seen by the second load
+            Plan* plan;
+            do {
+                plan = current.load();
+                in_use.store(plan);
+            } while (plan != current.load());
+
+            // a block larger than the one planned for is mixed in slices of it
+            const auto capacity = samples - samples % static_cast<std::size_t>(spec.channels);
+            for (std::size_t begin = 0; begin < out.size(); begin += capacity)
+                mix(*plan, out.subspan(begin, SDL::min(capacity, out.size() - begin)));
+
+            in_use.store(nullptr);
+        }
+
+        void mix(Plan& plan, const std::span<float> out) noexcept {
+            const auto n = out.size();
+            for (std::size_t i = 0; i < plan.buses.size(); ++ i)
+                std::fill_n(plan.buffer(i), n, 0.0f);
+
+            for (const auto i: plan.order) {
+                const auto& bus = plan.buses[i];
+                const auto buf = std::span{plan.buffer(i), n};
+
+                for (const auto stream: bus.inputs) {
+                    const auto got = SDL_GetAudioStreamData(stream -> handle, scratch.data(), static_cast<int>(n * sizeof(float)));
+                    if (got > 0)
+                        mixer::accumulate_f32(buf.data(), scratch.data(), 1.0f, static_cast<std::size_t>(got) / sizeof(float));
+                }
+
+                for (const auto& effect: bus.effects)
+                    (*effect)(spec, buf);
+
+                const auto target = i == 0 ? out.data() : plan.buffer(static_cast<std::size_t>(bus.parent));
+                mixer::accumulate_f32(target, buf.data(), bus.gain, n);
+            }
+        }
+
+        // snapshot the buses for the audio thread, lock held
+        void publish() {
+            auto plan = std::make_unique<Plan>(Plan{buses, order, samples, std::vector<float>(buses.size() * samples)});
+            // nothing may throw once the audio thread can see the new plan
+            retired.reserve(retired.size() + 1);
+            current.store(plan.get());
+            if (published)
+                retired.push_back(std::move(published));
+            published = std::move(plan);
+            collect();
+        }
+
+        // free the retired plans the audio thread is not reading, lock held
+        void collect() noexcept {
+            std::erase_if(retired, [this](const std::unique_ptr<Plan>& plan) {
+                return plan.get() != in_use.load();
+            });
+        }
+
+        Bus& at(const BusID id) noexcept {
+            return buses[static_cast<std::size_t>(id)];
+        }
+
+        void check(const BusID id) const {
+            if (static_cast<int>(id) < 0 || static_cast<std::size_t>(id) >= buses.size()) {
+                SDL_SetError("no such bus: %d", static_cast<int>(id));
+                throw Error{};
+            }
+        }
+
+        void detach(AudioStream& stream) noexcept {
+            for (auto& bus: buses)
+                std::erase(bus.inputs, &stream);
+        }
+
+        // Kahn's algorithm over the child -> parent edges
+        void sort() {
+            auto pending = std::vector<int>(buses.size(), 0);
+            for (std::size_t i = 1; i < buses.size(); ++ i)
+                ++ pending[static_cast<std::size_t>(buses[i].parent)];
+
+            order.clear();
+            for (std::size_t i = 0; i < buses.size(); ++ i)
+                if (pending[i] == 0)
+                    order.push_back(static_cast<int>(i));
+
+            for (std::size_t k = 0; k < order.size(); ++ k) {
+                const auto i = order[k];
+                if (i == 0)
+                    continue;
+                if (-- pending[static_cast<std::size_t>(buses[i].parent)] == 0)
+                    order.push_back(static_cast<int>(buses[i].parent));
+            }
+        }
+    };
+}
+
+#endif //SDL_AUDIO_BUS_HPP
@@ -0,0 +1,247 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_CACHE_HPP
+#define SDL_AUDIO_CACHE_HPP
+#include "SDL_audio.hpp"
+#include "SDL_audio_convert.hpp"
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SDL {
+    // decoded samples in the spec they were requested in, immutable once cached
+    struct PcmClip {
+        AudioSpec
+            spec;
+        std::vector<std::byte>
+            data;
+
+        std::span<const Uint8> bytes() const noexcept {
+            return {reinterpret_cast<const Uint8*>(data.data()), data.size()};
+        }
+
+        std::size_t frames() const noexcept {
+            return data.size() / spec.frame_size();
+        }
+    };
+
+    namespace cache {
+        /**
+         * a file is the same file while its canonical path, size and modification time match,
+         * so editing an asset on disk misses instead of serving stale samples.
+         */
+        struct Key {
+            std::string
+                path;
+            std::uintmax_t
+                size;
+            std::filesystem::file_time_type::rep
+                time;
+            AudioSpec
+                spec;
+
+            explicit Key(const std::filesystem::path& file, const AudioSpec& spec):
+                spec{spec} {
+                auto ec = std::error_code{};
+                auto canonical = std::filesystem::weakly_canonical(file, ec);
+                path = (ec ? file : canonical).generic_string();
+                size = std::filesystem::file_size(file, ec);
+                if (ec)
+                    size = 0;
+                const auto t = std::filesystem::last_write_time(file, ec);
+                time = ec ? 0 : t.time_since_epoch().count();
+            }
+
+            bool operator == (const Key& other) const noexcept {
+                return path == other.path && size == other.size && time == other.time && spec == other.spec;
+            }
+        };
+
+        struct KeyHash {
+            std::size_t operator () (const Key& key) const noexcept {
+                auto h = std::hash<std::string>{}(key.path);
+                const auto mix = [&h](const std::size_t v) {
+                    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+                };
+                mix(static_cast<std::size_t>(key.size));
+                mix(static_cast<std::size_t>(key.time));
+                mix(static_cast<std::size_t>(key.spec.format));
+                mix(static_cast<std::size_t>(key.spec.channels));
+                mix(static_cast<std::size_t>(key.spec.freq));
+                return h;
+            }
+        };
+    }
+
+    /**
+     * shared cache of decoded and converted wav files.
+     *
+     * load() returns a reference counted handle, evicting an entry only drops the cache's reference,
+     * handles already given out stay valid until released.
+     * the byte budget counts the samples the cache itself keeps alive, least recently used go first,
+     * a clip larger than the whole budget is returned but never kept.
+     * concurrent loads of one key decode once, the other callers wait for that result
+     * (and count as hits, they did not touch the disk).
+     */
+    struct PcmCache {
+        using Handle = std::shared_ptr<const PcmClip>;
+
+        struct Stats {
+            Uint64
+                hits;
+            Uint64
+                misses;
+            Uint64
+                evictions;
+            std::size_t
+                bytes;
+            std::size_t
+                entries;
+        };
+
+        struct Entry {
+            cache::Key
+                key;
+            Handle
+                clip;
+        };
+
+        std::size_t
+            budget;
+        std::size_t
+            bytes{0};
+        // front is the most recently used
+        std::list<Entry>
+            lru;
+        std::unordered_map<cache::Key, std::list<Entry>::iterator, cache::KeyHash>
+            index;
+        std::unordered_map<cache::Key, std::shared_future<Handle>, cache::KeyHash>
+            loading;
+        std::mutex
+            lock;
+        std::atomic<Uint64>
+            hits{0};
+        std::atomic<Uint64>
+            misses{0};
+        std::atomic<Uint64>
+            evictions{0};
+
+        explicit PcmCache(const std::size_t budget=64 << 20):
+            budget{budget} {}
+
+        PcmCache(const PcmCache&)=delete;
+        PcmCache& operator = (const PcmCache&)=delete;
+
+        Handle load(const std::filesystem::path& path, const AudioSpec& spec) {
+            auto key = cache::Key{path, spec};
+
+            auto promise = std::promise<Handle>{};
+            {
+                auto guard = std::unique_lock{lock};
+                if (const auto it = index.find(key); it != index.end()) {
+                    lru.splice(lru.begin(), lru, it -> second);
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return it -> second -> clip;
+                }
+                if (const auto it = loading.find(key); it != loading.end()) {
+                    auto pending = it -> second;
+                    guard.unlock();
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return pending.get();
+                }
+                loading.emplace(key, promise.get_future().share());
+            }
+            misses.fetch_add(1, std::memory_order_relaxed);
+
+            Handle clip;
+            try {
+                clip = decode(path, spec);
+            }
+            catch (...) {
+                {
+                    auto guard = std::scoped_lock{lock};
+                    loading.erase(key);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+
+            {
+                auto guard = std::scoped_lock{lock};
+                loading.erase(key);
+                if (clip -> data.size() <= budget && !index.contains(key)) {
+                    lru.push_front(Entry{key, clip});
+                    index.emplace(std::move(key), lru.begin());
+                    bytes += clip -> data.size();
+                    trim();
+                }
+            }
+            promise.set_value(clip);
+            return clip;
+        }
+
+        void resize(const std::size_t new_budget) {
+            auto guard = std::scoped_lock{lock};
+            budget = new_budget;
+            trim();
+        }
+
+        // drop every cached clip, handles in use are not affected
+        void clear() {
+            auto guard = std::scoped_lock{lock};
+            evictions.fetch_add(lru.size(), std::memory_order_relaxed);
+            index.clear();
+            lru.clear();
+            bytes = 0;
+        }
+
+        Stats stats() {
+            auto guard = std::scoped_lock{lock};
+            return {
+                hits.load(std::memory_order_relaxed),
+                misses.load(std::memory_order_relaxed),
+                evictions.load(std::memory_order_relaxed),
+                bytes,
+                lru.size()
+            };
+        }
+
+        // lock held
+        void trim() {
+            while (bytes > budget && !lru.empty()) {
+                auto& victim = lru.back();
+                bytes -= victim.clip -> data.size();
+                index.erase(victim.key);
+                lru.pop_back();
+                evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        static Handle decode(const std::filesystem::path& path, const AudioSpec& spec) {
+            auto [src_spec, src] = load_wav(path);
+            const auto samples = std::span{reinterpret_cast<const std::byte*>(src.data), static_cast<std::size_t>(src.size)};
+
+            auto clip = std::make_shared<PcmClip>();
+            clip -> spec = spec;
+            if (src_spec == spec)
+                clip -> data.assign(samples.begin(), samples.end());
+            else {
+                const auto written = AudioConverter{src_spec, spec}(samples, clip -> data).size();
+                clip -> data.resize(written);
+                clip -> data.shrink_to_fit();
+            }
+            return clip;
+        }
+    };
+}
+
+#endif //SDL_AUDIO_CACHE_HPP
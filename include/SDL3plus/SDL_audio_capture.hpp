@@ -0,0 +1,289 @@
+//
+// Created by FCWY on 26-10-17.
+//
+// ReSharper disable CppMemberFunctionMayBeConst
+#ifndef SDL_AUDIO_CAPTURE_HPP
+#define SDL_AUDIO_CAPTURE_HPP
+#include <SDL3/SDL_timer.h>
+#include "SDL_audio.hpp"
+#include "SDL_cpuinfo.hpp"
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace SDL {
+    namespace capture {
+        /**
+         * single producer / single consumer queue of block indices,
+         * capacity is a power of 2 no smaller than the number of blocks, so push never fails in use.
+         */
+        struct IndexQueue {
+            std::unique_ptr<Uint32[]>
+                slots;
+            std::size_t
+                mask;
+
+            alignas(cacheline_size) std::atomic_size_t
+                head{0};
+            alignas(cacheline_size) std::atomic_size_t
+                tail{0};
+
+            explicit IndexQueue(const std::size_t capacity):
+                slots{std::make_unique<Uint32[]>(std::bit_ceil(capacity))},
+                mask{std::bit_ceil(capacity) - 1} {}
+
+            bool push(const Uint32 index) noexcept {
+                const auto h = head.load(std::memory_order_relaxed);
+                if (h - tail.load(std::memory_order_acquire) > mask)
+                    return false;
+                slots[h & mask] = index;
+                head.store(h + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool pop(Uint32& index) noexcept {
+                const auto t = tail.load(std::memory_order_relaxed);
+                if (t == head.load(std::memory_order_acquire))
+                    return false;
+                index = slots[t & mask];
+                tail.store(t + 1, std::memory_order_release);
+                return true;
+            }
+
+            std::size_t size() const noexcept {
+                return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+            }
+        };
+    }
+
+    struct CapturePipeline;
+
+    /**
+     * one filled block, read-only, handed back to the pipeline when destroyed.
+     * must not outlive the pipeline
+     */
+    struct CaptureBlock {
+        CapturePipeline*
+            owner{nullptr};
+        Uint32
+            index{0};
+
+        CaptureBlock() noexcept=default;
+        CaptureBlock(CapturePipeline* owner, const Uint32 index) noexcept:
+            owner{owner},
+            index{index} {}
+
+        CaptureBlock(const CaptureBlock&)=delete;
+        CaptureBlock& operator = (const CaptureBlock&)=delete;
+
+        CaptureBlock(CaptureBlock&& other) noexcept:
+            owner{std::exchange(other.owner, nullptr)},
+            index{other.index} {}
+
+        CaptureBlock& operator = (CaptureBlock&& other) noexcept {
+            std::swap(owner, other.owner);
+            std::swap(index, other.index);
+            return *this;
+        }
+
+        ~CaptureBlock() noexcept;
+
+        explicit operator bool () const noexcept {
+            return owner != nullptr;
+        }
+
+        std::span<const std::byte> data() const noexcept;
+
+        // SDL_GetTicksNS when the block was completed, for latency measurements
+        Uint64 ticks() const noexcept;
+    };
+
+    /**
+     * recording stream -> fixed size blocks -> consumer thread, no lock and no allocation after construction.
+     *
+     * the stream's put-callback (audio thread, fired when the recording device delivers)
+     * pulls the converted samples into the current block, a full block goes to the ready queue,
+     * the next one comes from the free queue. the consumer takes blocks as read-only spans
+     * straight out of the block memory and the blocks return to the free queue when released.
+     * if the consumer falls behind and no free block is left, incoming audio is dropped
+     * (drained into a spare block, SDL's queue does not grow) and counted as an overrun,
+     * filling resumes with the next block the consumer hands back.
+     * take() sleeps on an atomic wait, the audio thread only pays a notify per block.
+     * stop() wakes a sleeping take(), which returns an empty block from then on.
+     *
+     * the stream (created for the recording device, dst spec = the spec blocks are made of)
+     * must outlive the pipeline, its put-callback is owned by the pipeline while the pipeline is alive.
+     */
+    struct CapturePipeline {
+        AudioStream&
+            stream;
+        std::size_t
+            block_bytes;
+        // block_bytes rounded up to whole cache lines
+        std::size_t
+            stride;
+        Uint32
+            blocks;
+        std::byte*
+            memory;
+        std::unique_ptr<Uint64[]>
+            completed;
+
+        capture::IndexQueue
+            free_blocks;
+        capture::IndexQueue
+            ready_blocks;
+
+        // audio thread only, current == spare() while dropping
+        Uint32
+            current{0};
+        std::size_t
+            filled{0};
+
+        alignas(cacheline_size) std::atomic<Uint64>
+            produced{0};
+        // reads thrown away because every block was queued or held
+        std::atomic<Uint64>
+            overruns{0};
+        std::atomic_bool
+            stopping{false};
+
+        /**
+         * block_frames frames per block, in the stream's output spec,
+         * `blocks` of them rotate between the audio thread and the consumer.
+         * one more is allocated as the spare overruns are drained into
+         */
+        CapturePipeline(AudioStream& stream, const std::size_t block_frames, const Uint32 blocks=8):
+            stream{stream},
+            block_bytes{block_frames * static_cast<std::size_t>(stream.format().second.frame_size())},
+            stride{(block_bytes + cacheline_size - 1) / cacheline_size * cacheline_size},
+            blocks{blocks},
+            memory{nullptr},
+            completed{std::make_unique<Uint64[]>(blocks + 1)},
+            free_blocks{blocks},
+            ready_blocks{blocks} {
+            if (block_bytes == 0 || blocks < 2) {
+                SDL_SetError("capture needs at least 2 non empty blocks");
+                throw Error{};
+            }
+
+            memory = static_cast<std::byte*>(aligned::alloc(cacheline_size, stride * (blocks + 1)));
+            if (!memory)
+                throw Error{};
+
+            for (Uint32 i = 1; i < blocks; ++ i)
+                free_blocks.push(i);
+
+            try {
+                stream.add_callback_put(on_put, this);
+            }
+            catch (Error&) {
+                aligned::free(memory);
+                throw;
+            }
+        }
+
+        CapturePipeline(const CapturePipeline&)=delete;
+        CapturePipeline& operator = (const CapturePipeline&)=delete;
+
+        // every CaptureBlock must be gone by now
+        ~CapturePipeline() noexcept {
+            SDL_SetAudioStreamPutCallback(stream.handle, nullptr, nullptr);
+            aligned::free(memory);
+        }
+
+        Uint32 spare() const noexcept {
+            return blocks;
+        }
+
+        std::byte* block(const Uint32 index) const noexcept {
+            return memory + static_cast<std::size_t>(index) * stride;
+        }
+
+        // consumer side, empty CaptureBlock if nothing is ready
+        CaptureBlock try_take() noexcept {
+            Uint32 index;
+            if (!ready_blocks.pop(index))
+                return {};
+            return {this, index};
+        }
+
+        // consumer side, sleeps on the produced counter until a block is ready, empty CaptureBlock once stopped
+        CaptureBlock take() noexcept {
+            for (;;) {
+                const auto seen = produced.load(std::memory_order_acquire);
+                if (stopping.load(std::memory_order_acquire))
+                    return {};
+                if (auto ret = try_take())
+                    return ret;
+                produced.wait(seen, std::memory_order_acquire);
+            }
+        }
+
+        // any thread, releases the consumer from take() for shutdown. blocks still ready remain for try_take()
+        void stop() noexcept {
+            stopping.store(true, std::memory_order_release);
+            produced.fetch_add(1, std::memory_order_release);
+            produced.notify_all();
+        }
+
+        // blocks waiting for the consumer
+        std::size_t ready() const noexcept {
+            return ready_blocks.size();
+        }
+
+        void release(const Uint32 index) noexcept {
+            free_blocks.push(index);
+        }
+
+        // audio thread
+        void receive() noexcept {
+            for (;;) {
+                if (current == spare() && !free_blocks.pop(current)) {
+                    const auto got = SDL_GetAudioStreamData(stream.handle, block(current), static_cast<int>(block_bytes));
+                    if (got <= 0)
+                        return;
+                    overruns.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                const auto got = SDL_GetAudioStreamData(stream.handle, block(current) + filled, static_cast<int>(block_bytes - filled));
+                if (got <= 0)
+                    return;
+                filled += static_cast<std::size_t>(got);
+                if (filled < block_bytes)
+                    continue;
+
+                completed[current] = SDL_GetTicksNS();
+                ready_blocks.push(current);
+                produced.fetch_add(1, std::memory_order_release);
+                produced.notify_one();
+
+                filled = 0;
+                if (!free_blocks.pop(current))
+                    current = spare();
+            }
+        }
+
+        static void SDLCALL on_put(void* userdata, SDL_AudioStream*, int, int) noexcept {
+            static_cast<CapturePipeline*>(userdata) -> receive();
+        }
+    };
+
+    inline CaptureBlock::~CaptureBlock() noexcept {
+        if (owner)
+            owner -> release(index);
+    }
+
+    inline std::span<const std::byte> CaptureBlock::data() const noexcept {
+        return {owner -> block(index), owner -> block_bytes};
+    }
+
+    inline Uint64 CaptureBlock::ticks() const noexcept {
+        return owner -> completed[index];
+    }
+}
+
+#endif //SDL_AUDIO_CAPTURE_HPP
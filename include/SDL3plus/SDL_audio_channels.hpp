@@ -0,0 +1,413 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_CHANNELS_HPP
+#define SDL_AUDIO_CHANNELS_HPP
+#include "SDL_audio.hpp"
+#include "SDL_intrin.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <span>
+#include <utility>
+
+namespace SDL {
+    /**
+     * planar <-> interleaved kernels and channel map shuffles.
+     *
+     * channel maps have the layout SDL uses for input_channels / output_channels:
+     * map[c] is the source channel written to channel c, -1 writes silence.
+     * source and destination must not overlap.
+     */
+    namespace channels {
+        template<typename T>
+        concept Sample = std::same_as<T, Sint16> || std::same_as<T, Sint32> || std::same_as<T, float>;
+
+        constexpr int max_channels = 8;
+
+        /**
+         * vector part of interleave, Size is the sample width in bytes.
+         * SSE2: stereo (16 and 32 bit) and quad (32 bit), NEON: 2 to 4 channels through vst2/3/4.
+         * returns: frames done, the scalar loop finishes the rest
+         */
+        template<std::size_t Size, int Channels>
+        std::size_t interleave_vector(const void* const* planes, void* dst, const std::size_t frames) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            if constexpr (Size == 4 && Channels == 2) {
+                const auto l = static_cast<const float*>(planes[0]);
+                const auto r = static_cast<const float*>(planes[1]);
+                const auto d = static_cast<float*>(dst);
+                for (; i + 4 <= frames; i += 4) {
+                    const auto a = _mm_loadu_ps(l + i);
+                    const auto b = _mm_loadu_ps(r + i);
+                    _mm_storeu_ps(d + 2 * i,     _mm_unpacklo_ps(a, b));
+                    _mm_storeu_ps(d + 2 * i + 4, _mm_unpackhi_ps(a, b));
+                }
+            }
+            else if constexpr (Size == 4 && Channels == 4) {
+                const auto d = static_cast<float*>(dst);
+                for (; i + 4 <= frames; i += 4) {
+                    auto a = _mm_loadu_ps(static_cast<const float*>(planes[0]) + i);
+                    auto b = _mm_loadu_ps(static_cast<const float*>(planes[1]) + i);
+                    auto c = _mm_loadu_ps(static_cast<const float*>(planes[2]) + i);
+                    auto e = _mm_loadu_ps(static_cast<const float*>(planes[3]) + i);
+                    _MM_TRANSPOSE4_PS(a, b, c, e);
+                    _mm_storeu_ps(d + 4 * i,      a);
+                    _mm_storeu_ps(d + 4 * i + 4,  b);
+                    _mm_storeu_ps(d + 4 * i + 8,  c);
+                    _mm_storeu_ps(d + 4 * i + 12, e);
+                }
+            }
+            else if constexpr (Size == 2 && Channels == 2) {
+                const auto l = static_cast<const Sint16*>(planes[0]);
+                const auto r = static_cast<const Sint16*>(planes[1]);
+                const auto d = static_cast<Sint16*>(dst);
+                for (; i + 8 <= frames; i += 8) {
+                    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i));
+                    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 2 * i),     _mm_unpacklo_epi16(a, b));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 2 * i + 8), _mm_unpackhi_epi16(a, b));
+                }
+            }
+#elif defined(SDL3PLUS_NEON)
+            if constexpr (Size == 4 && Channels >= 2 && Channels <= 4) {
+                const auto p = reinterpret_cast<const uint32_t* const*>(planes);
+                const auto d = static_cast<uint32_t*>(dst);
+                for (; i + 4 <= frames; i += 4) {
+                    if constexpr (Channels == 2)
+                        vst2q_u32(d + 2 * i, (uint32x4x2_t{{vld1q_u32(p[0] + i), vld1q_u32(p[1] + i)}}));
+                    else if constexpr (Channels == 3)
+                        vst3q_u32(d + 3 * i, (uint32x4x3_t{{vld1q_u32(p[0] + i), vld1q_u32(p[1] + i), vld1q_u32(p[2] + i)}}));
+                    else
+                        vst4q_u32(d + 4 * i, (uint32x4x4_t{{vld1q_u32(p[0] + i), vld1q_u32(p[1] + i), vld1q_u32(p[2] + i), vld1q_u32(p[3] + i)}}));
+                }
+            }
+            else if constexpr (Size == 2 && Channels >= 2 && Channels <= 4) {
+                const auto p = reinterpret_cast<const uint16_t* const*>(planes);
+                const auto d = static_cast<uint16_t*>(dst);
+                for (; i + 8 <= frames; i += 8) {
+                    if constexpr (Channels == 2)
+                        vst2q_u16(d + 2 * i, (uint16x8x2_t{{vld1q_u16(p[0] + i), vld1q_u16(p[1] + i)}}));
+                    else if constexpr (Channels == 3)
+                        vst3q_u16(d + 3 * i, (uint16x8x3_t{{vld1q_u16(p[0] + i), vld1q_u16(p[1] + i), vld1q_u16(p[2] + i)}}));
+                    else
+                        vst4q_u16(d + 4 * i, (uint16x8x4_t{{vld1q_u16(p[0] + i), vld1q_u16(p[1] + i), vld1q_u16(p[2] + i), vld1q_u16(p[3] + i)}}));
+                }
+            }
+#endif
+            return i;
+        }
+
+        // returns: frames done, the scalar loop finishes the rest
+        template<std::size_t Size, int Channels>
+        std::size_t deinterleave_vector(const void* src, void* const* planes, const std::size_t frames) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            if constexpr (Size == 4 && Channels == 2) {
+                const auto s = static_cast<const float*>(src);
+                const auto l = static_cast<float*>(planes[0]);
+                const auto r = static_cast<float*>(planes[1]);
+                for (; i + 4 <= frames; i += 4) {
+                    const auto a = _mm_loadu_ps(s + 2 * i);
+                    const auto b = _mm_loadu_ps(s + 2 * i + 4);
+                    _mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                    _mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                }
+            }
+            else if constexpr (Size == 4 && Channels == 4) {
+                const auto s = static_cast<const float*>(src);
+                for (; i + 4 <= frames; i += 4) {
+                    auto a = _mm_loadu_ps(s + 4 * i);
+                    auto b = _mm_loadu_ps(s + 4 * i + 4);
+                    auto c = _mm_loadu_ps(s + 4 * i + 8);
+                    auto e = _mm_loadu_ps(s + 4 * i + 12);
+                    _MM_TRANSPOSE4_PS(a, b, c, e);
+                    _mm_storeu_ps(static_cast<float*>(planes[0]) + i, a);
+                    _mm_storeu_ps(static_cast<float*>(planes[1]) + i, b);
+                    _mm_storeu_ps(static_cast<float*>(planes[2]) + i, c);
+                    _mm_storeu_ps(static_cast<float*>(planes[3]) + i, e);
+                }
+            }
+            else if constexpr (Size == 2 && Channels == 2) {
+                const auto s = static_cast<const Sint16*>(src);
+                const auto l = static_cast<Sint16*>(planes[0]);
+                const auto r = static_cast<Sint16*>(planes[1]);
+                for (; i + 8 <= frames; i += 8) {
+                    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i));
+                    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i + 8));
+                    // even lanes sign extended in place, odd lanes shifted down, packs never saturates
+                    const auto even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+                    const auto odd  = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(l + i), even);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), odd);
+                }
+            }
+#elif defined(SDL3PLUS_NEON)
+            if constexpr (Size == 4 && Channels >= 2 && Channels <= 4) {
+                const auto s = static_cast<const uint32_t*>(src);
+                const auto p = reinterpret_cast<uint32_t* const*>(planes);
+                for (; i + 4 <= frames; i += 4) {
+                    if constexpr (Channels == 2) {
+                        const auto v = vld2q_u32(s + 2 * i);
+                        vst1q_u32(p[0] + i, v.val[0]);
+                        vst1q_u32(p[1] + i, v.val[1]);
+                    }
+                    else if constexpr (Channels == 3) {
+                        const auto v = vld3q_u32(s + 3 * i);
+                        vst1q_u32(p[0] + i, v.val[0]);
+                        vst1q_u32(p[1] + i, v.val[1]);
+                        vst1q_u32(p[2] + i, v.val[2]);
+                    }
+                    else {
+                        const auto v = vld4q_u32(s + 4 * i);
+                        vst1q_u32(p[0] + i, v.val[0]);
+                        vst1q_u32(p[1] + i, v.val[1]);
+                        vst1q_u32(p[2] + i, v.val[2]);
+                        vst1q_u32(p[3] + i, v.val[3]);
+                    }
+                }
+            }
+            else if constexpr (Size == 2 && Channels >= 2 && Channels <= 4) {
+                const auto s = static_cast<const uint16_t*>(src);
+                const auto p = reinterpret_cast<uint16_t* const*>(planes);
+                for (; i + 8 <= frames; i += 8) {
+                    if constexpr (Channels == 2) {
+                        const auto v = vld2q_u16(s + 2 * i);
+                        vst1q_u16(p[0] + i, v.val[0]);
+                        vst1q_u16(p[1] + i, v.val[1]);
+                    }
+                    else if constexpr (Channels == 3) {
+                        const auto v = vld3q_u16(s + 3 * i);
+                        vst1q_u16(p[0] + i, v.val[0]);
+                        vst1q_u16(p[1] + i, v.val[1]);
+                        vst1q_u16(p[2] + i, v.val[2]);
+                    }
+                    else {
+                        const auto v = vld4q_u16(s + 4 * i);
+                        vst1q_u16(p[0] + i, v.val[0]);
+                        vst1q_u16(p[1] + i, v.val[1]);
+                        vst1q_u16(p[2] + i, v.val[2]);
+                        vst1q_u16(p[3] + i, v.val[3]);
+                    }
+                }
+            }
+#endif
+            return i;
+        }
+
+        // a null plane is silence
+        template<Sample T, int Channels>
+        void interleave(const T* const* planes, T* dst, const std::size_t frames) noexcept {
+            std::size_t i = 0;
+            if (std::all_of(planes, planes + Channels, [](const T* p) noexcept { return p != nullptr; }))
+                i = interleave_vector<sizeof(T), Channels>(reinterpret_cast<const void* const*>(planes), dst, frames);
+
+            for (; i < frames; ++ i)
+                for (int c = 0; c < Channels; ++ c)
+                    dst[i * Channels + c] = planes[c] ? planes[c][i] : T{};
+        }
+
+        // a null plane is skipped
+        template<Sample T, int Channels>
+        void deinterleave(const T* src, T* const* planes, const std::size_t frames) noexcept {
+            std::size_t i = 0;
+            if (std::all_of(planes, planes + Channels, [](const T* p) noexcept { return p != nullptr; }))
+                i = deinterleave_vector<sizeof(T), Channels>(src, reinterpret_cast<void* const*>(planes), frames);
+
+            for (; i < frames; ++ i)
+                for (int c = 0; c < Channels; ++ c)
+                    if (planes[c])
+                        planes[c][i] = src[i * Channels + c];
+        }
+
+        /**
+         * interleaved -> interleaved through a byte shuffle (pshufb / tbl),
+         * as many whole frames per 16 byte register as both layouts allow.
+         * returns: frames done, 0 when a frame does not fit a register or there is no byte shuffle
+         */
+        template<Sample T>
+        std::size_t remap_vector([[maybe_unused]] const T* src, [[maybe_unused]] const int src_channels, [[maybe_unused]] T* dst,
+                                 [[maybe_unused]] const std::span<const int> map, [[maybe_unused]] const std::size_t frames) noexcept {
+#if defined(SDL3PLUS_SSSE3) || defined(SDL3PLUS_NEON)
+            const auto src_frame = sizeof(T) * src_channels;
+            const auto dst_frame = sizeof(T) * map.size();
+            const auto widest = SDL::max(src_frame, dst_frame);
+            if (widest > 16)
+                return 0;
+
+            // whole frames per register, lanes past them are zeroed and overwritten by the next store
+            const auto per = 16 / widest;
+            alignas(16) Uint8 table[16];
+            std::memset(table, 0xFF, sizeof table);
+            for (std::size_t j = 0; j < per * dst_frame; ++ j) {
+                const auto frame = j / dst_frame;
+                const auto channel = (j % dst_frame) / sizeof(T);
+                const auto byte = j % sizeof(T);
+                if (map[channel] >= 0)
+                    table[j] = static_cast<Uint8>(frame * src_frame + map[channel] * sizeof(T) + byte);
+            }
+
+            const auto s = reinterpret_cast<const Uint8*>(src);
+            const auto d = reinterpret_cast<Uint8*>(dst);
+            const auto src_bytes = frames * src_frame;
+            const auto dst_bytes = frames * dst_frame;
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSSE3)
+            const auto shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+            for (; i * src_frame + 16 <= src_bytes && i * dst_frame + 16 <= dst_bytes; i += per)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * dst_frame),
+                    _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * src_frame)), shuffle));
+#else
+            const auto shuffle = vld1q_u8(table);
+            for (; i * src_frame + 16 <= src_bytes && i * dst_frame + 16 <= dst_bytes; i += per)
+                vst1q_u8(d + i * dst_frame, vqtbl1q_u8(vld1q_u8(s + i * src_frame), shuffle));
+#endif
+            return i;
+#else
+            return 0;
+#endif
+        }
+
+        template<Sample T, int Channels>
+        void remap(const T* src, const int src_channels, T* dst, const std::span<const int> map, const std::size_t frames) noexcept {
+            auto i = remap_vector(src, src_channels, dst, map, frames);
+
+            int m[Channels];
+            std::copy_n(map.data(), Channels, m);
+            for (; i < frames; ++ i)
+                for (int c = 0; c < Channels; ++ c)
+                    dst[i * Channels + c] = m[c] < 0 ? T{} : src[i * src_channels + m[c]];
+        }
+
+        template<Sample T>
+        using InterleaveFunction = void (*)(const T* const*, T*, std::size_t) noexcept;
+        template<Sample T>
+        using DeinterleaveFunction = void (*)(const T*, T* const*, std::size_t) noexcept;
+        template<Sample T>
+        using RemapFunction = void (*)(const T*, int, T*, std::span<const int>, std::size_t) noexcept;
+
+        template<Sample T, std::size_t... N>
+        constexpr auto interleavers(std::index_sequence<N...>) noexcept {
+            return std::array<InterleaveFunction<T>, max_channels>{&interleave<T, static_cast<int>(N) + 1>...};
+        }
+
+        template<Sample T, std::size_t... N>
+        constexpr auto deinterleavers(std::index_sequence<N...>) noexcept {
+            return std::array<DeinterleaveFunction<T>, max_channels>{&deinterleave<T, static_cast<int>(N) + 1>...};
+        }
+
+        template<Sample T, std::size_t... N>
+        constexpr auto remappers(std::index_sequence<N...>) noexcept {
+            return std::array<RemapFunction<T>, max_channels>{&remap<T, static_cast<int>(N) + 1>...};
+        }
+
+        inline void check_channels(const std::size_t n) {
+            if (n < 1 || n > max_channels) {
+                SDL_SetError("unsupported channel count: %zu", n);
+                throw Error{};
+            }
+        }
+
+        inline void check_map(const std::span<const int> map, const std::size_t src_channels) {
+            check_channels(map.size());
+            for (const auto c: map)
+                if (c < -1 || c >= static_cast<int>(src_channels)) {
+                    SDL_SetError("channel map entry %d out of range for %zu channels", c, src_channels);
+                    throw Error{};
+                }
+        }
+    }
+
+    /**
+     * planes[c] -> channel c of dst, frames = dst.size() / planes.size().
+     * a null plane writes silence
+     */
+    template<channels::Sample T>
+    void interleave(const std::span<const T* const> planes, const std::span<T> dst) {
+        channels::check_channels(planes.size());
+        static constexpr auto table = channels::interleavers<T>(std::make_index_sequence<channels::max_channels>{});
+        table[planes.size() - 1](planes.data(), dst.data(), dst.size() / planes.size());
+    }
+
+    // channel c of dst is planes[map[c]], the map picks planes and decides the channel count
+    template<channels::Sample T>
+    void interleave(const std::span<const T* const> planes, const std::span<T> dst, const std::span<const int> map) {
+        channels::check_map(map, planes.size());
+        const T* ordered[channels::max_channels];
+        for (std::size_t c = 0; c < map.size(); ++ c)
+            ordered[c] = map[c] < 0 ? nullptr : planes[map[c]];
+        interleave<T>(std::span{ordered, map.size()}, dst);
+    }
+
+    template<channels::Sample T>
+    void interleave(const std::span<const T* const> planes, const std::span<T> dst, const List<int>& map) {
+        interleave<T>(planes, dst, std::span<const int>{map.data, static_cast<std::size_t>(map.size)});
+    }
+
+    /**
+     * channel c of src -> planes[c], frames = src.size() / planes.size().
+     * a null plane is skipped
+     */
+    template<channels::Sample T>
+    void deinterleave(const std::span<const T> src, const std::span<T* const> planes) {
+        channels::check_channels(planes.size());
+        static constexpr auto table = channels::deinterleavers<T>(std::make_index_sequence<channels::max_channels>{});
+        table[planes.size() - 1](src.data(), planes.data(), src.size() / planes.size());
+    }
+
+    // planes[c] receives channel map[c] of src, -1 fills the plane with silence
+    template<channels::Sample T>
+    void deinterleave(const std::span<const T> src, const int src_channels, const std::span<T* const> planes, const std::span<const int> map) {
+        channels::check_channels(static_cast<std::size_t>(src_channels));
+        channels::check_map(map, static_cast<std::size_t>(src_channels));
+        if (map.size() != planes.size()) {
+            SDL_SetError("channel map has %zu entries for %zu planes", map.size(), planes.size());
+            throw Error{};
+        }
+
+        // every source channel goes to its first plane, repeats are copied from there afterward
+        const auto frames = src.size() / src_channels;
+        T* targets[channels::max_channels]{};
+        for (std::size_t c = 0; c < map.size(); ++ c)
+            if (map[c] >= 0 && !targets[map[c]])
+                targets[map[c]] = planes[c];
+        deinterleave<T>(src.first(frames * src_channels), std::span{targets, static_cast<std::size_t>(src_channels)});
+
+        for (std::size_t c = 0; c < map.size(); ++ c)
+            if (map[c] < 0)
+                std::fill_n(planes[c], frames, T{});
+            else if (targets[map[c]] != planes[c])
+                std::copy_n(targets[map[c]], frames, planes[c]);
+    }
+
+    template<channels::Sample T>
+    void deinterleave(const std::span<const T> src, const int src_channels, const std::span<T* const> planes, const List<int>& map) {
+        deinterleave<T>(src, src_channels, planes, std::span<const int>{map.data, static_cast<std::size_t>(map.size)});
+    }
+
+    /**
+     * interleaved -> interleaved, channel c of dst is channel map[c] of src (or silence for -1),
+     * dst has map.size() channels. frames: as many as both buffers hold
+     * returns: frames written
+     */
+    template<channels::Sample T>
+    std::size_t remap_channels(const std::span<const T> src, const int src_channels, const std::span<T> dst, const std::span<const int> map) {
+        channels::check_channels(static_cast<std::size_t>(src_channels));
+        channels::check_map(map, static_cast<std::size_t>(src_channels));
+
+        static constexpr auto table = channels::remappers<T>(std::make_index_sequence<channels::max_channels>{});
+        const auto frames = SDL::min(src.size() / src_channels, dst.size() / map.size());
+        table[map.size() - 1](src.data(), src_channels, dst.data(), map, frames);
+        return frames;
+    }
+
+    template<channels::Sample T>
+    std::size_t remap_channels(const std::span<const T> src, const int src_channels, const std::span<T> dst, const List<int>& map) {
+        return remap_channels<T>(src, src_channels, dst, std::span<const int>{map.data, static_cast<std::size_t>(map.size)});
+    }
+}
+
+#endif //SDL_AUDIO_CHANNELS_HPP
@@ -0,0 +1,332 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_CONVERT_HPP
+#define SDL_AUDIO_CONVERT_HPP
+#include "SDL_audio.hpp"
+#include "SDL_endian.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace SDL {
+    namespace convert {
+        constexpr bool native_bigendian = SDL_BYTEORDER == SDL_BIG_ENDIAN;
+
+        // every distinct layout SDL knows, S16/S32/F32 are aliases of the native ones
+        constexpr std::array formats {
+            AudioFormat::U8,
+            AudioFormat::S8,
+            AudioFormat::S16LE,
+            AudioFormat::S16BE,
+            AudioFormat::S32LE,
+            AudioFormat::S32BE,
+            AudioFormat::F32LE,
+            AudioFormat::F32BE,
+        };
+
+        constexpr int max_channels = 8;
+
+        constexpr int index_of(const AudioFormat format) noexcept {
+            for (std::size_t i = 0; i < formats.size(); ++ i)
+                if (formats[i] == format)
+                    return static_cast<int>(i);
+            return -1;
+        }
+
+        template<AudioFormat F>
+        struct Sample {
+            static_assert(bitsize(F) == 8 || bitsize(F) == 16 || bitsize(F) == 32);
+
+            using type =
+                std::conditional_t<is_float(F), float,
+                std::conditional_t<bitsize(F) == 8, std::conditional_t<is_signed(F), Sint8, Uint8>,
+                std::conditional_t<bitsize(F) == 16, Sint16, Sint32>>>;
+
+            static constexpr bool swapped = bitsize(F) > 8 && is_bigendian(F) != native_bigendian;
+
+            static type load(const std::byte* const src) noexcept {
+                type v;
+                std::memcpy(&v, src, sizeof(type));
+                if constexpr (!swapped)
+                    return v;
+                else if constexpr (is_float(F))
+                    return SDL_SwapFloat(v);
+                else if constexpr (bitsize(F) == 16)
+                    return static_cast<type>(SDL_Swap16(static_cast<Uint16>(v)));
+                else
+                    return static_cast<type>(SDL_Swap32(static_cast<Uint32>(v)));
+            }
+
+            static void store(std::byte* const dst, type v) noexcept {
+                if constexpr (!swapped) {}
+                else if constexpr (is_float(F))
+                    v = SDL_SwapFloat(v);
+                else if constexpr (bitsize(F) == 16)
+                    v = static_cast<type>(SDL_Swap16(static_cast<Uint16>(v)));
+                else
+                    v = static_cast<type>(SDL_Swap32(static_cast<Uint32>(v)));
+                std::memcpy(dst, &v, sizeof(type));
+            }
+        };
+
+        /**
+         * one sample From -> To, every branch is decided at compile time.
+         * integer <-> integer: shifts (U8 is re-biased), same as SDL's exact paths
+         * integer  -> float:   scale into [-1, 1)
+         * float    -> integer: clamp and scale, NaN -> 0
+         */
+        template<AudioFormat From, AudioFormat To>
+        typename Sample<To>::type sample(const typename Sample<From>::type v) noexcept {
+            using to_t = typename Sample<To>::type;
+
+            if constexpr (is_float(From) && is_float(To))
+                return v;
+            else if constexpr (is_float(From)) {
+                constexpr auto scale = static_cast<float>(1ull << (bitsize(To) - 1));
+                // NaN passes through clamp and its cast to int is undefined, it becomes silence
+                const auto x = std::clamp(v == v ? v : 0.0f, -1.0f, 1.0f);
+                if constexpr (bitsize(To) == 32) {
+                    // 2^31 is not representable in Sint32, saturate by hand
+                    const auto y = x * scale;
+                    return y >= scale ? max_int32 : static_cast<Sint32>(y);
+                }
+                else {
+                    const auto y = static_cast<Sint32>(x * scale);
+                    const auto z = SDL::min(y, static_cast<Sint32>(scale) - 1);
+                    if constexpr (is_signed(To))
+                        return static_cast<to_t>(z);
+                    else
+                        return static_cast<to_t>(z ^ 0x80);
+                }
+            }
+            else {
+                // to signed 32 bit first, U8 re-biased, the value kept left aligned
+                Sint32 s;
+                if constexpr (is_signed(From))
+                    s = static_cast<Sint32>(static_cast<Uint32>(static_cast<Sint32>(v)) << (32 - bitsize(From)));
+                else
+                    s = static_cast<Sint32>(static_cast<Uint32>(v ^ 0x80) << 24);
+
+                if constexpr (is_float(To))
+                    return static_cast<float>(s) * (1.0f / 2147483648.0f);
+                else if constexpr (is_signed(To))
+                    return static_cast<to_t>(s >> (32 - bitsize(To)));
+                else
+                    return static_cast<to_t>((s >> 24) ^ 0x80);
+            }
+        }
+    }
+
+    /**
+     * From / To / Channels fixed at compile time, so the loop is a straight
+     * load-convert-store over frames * Channels samples the compiler can unroll and vectorize.
+     * only the sample format changes, channel count and frequency are kept.
+     */
+    template<AudioFormat From, AudioFormat To, int Channels>
+    struct SampleConverter {
+        static_assert(Channels > 0);
+
+        static constexpr std::size_t src_frame = bytesize(From) * Channels;
+        static constexpr std::size_t dst_frame = bytesize(To) * Channels;
+
+        static void convert(const std::byte* const src, std::byte* const dst, const std::size_t frames) noexcept {
+            using from_s = convert::Sample<From>;
+            using to_s = convert::Sample<To>;
+
+            const auto n = frames * Channels;
+            if constexpr (From == To)
+                std::memcpy(dst, src, n * bytesize(From));
+            else
+                for (std::size_t i = 0; i < n; ++ i)
+                    to_s::store(
+                        dst + i * bytesize(To),
+                        convert::sample<From, To>(from_s::load(src + i * bytesize(From)))
+                    );
+        }
+
+        // returns: frames converted, limited by both buffers
+        static std::size_t convert(const std::span<const std::byte> src, const std::span<std::byte> dst) noexcept {
+            const auto frames = SDL::min(src.size() / src_frame, dst.size() / dst_frame);
+            convert(src.data(), dst.data(), frames);
+            return frames;
+        }
+    };
+
+    using ConvertFunction = void (*)(const std::byte* src, std::byte* dst, std::size_t frames) noexcept;
+
+    namespace convert {
+        using Table = std::array<std::array<std::array<ConvertFunction, max_channels>, formats.size()>, formats.size()>;
+
+        template<std::size_t From, std::size_t To, std::size_t... Ch>
+        constexpr std::array<ConvertFunction, max_channels> row(std::index_sequence<Ch...>) noexcept {
+            return {&SampleConverter<formats[From], formats[To], static_cast<int>(Ch) + 1>::convert...};
+        }
+
+        template<std::size_t From, std::size_t... To>
+        constexpr std::array<std::array<ConvertFunction, max_channels>, formats.size()> column(std::index_sequence<To...>) noexcept {
+            return {row<From, To>(std::make_index_sequence<max_channels>{})...};
+        }
+
+        template<std::size_t... From>
+        constexpr Table table(std::index_sequence<From...>) noexcept {
+            return {column<From>(std::make_index_sequence<formats.size()>{})...};
+        }
+    }
+
+    /**
+     * pick the specialised converter for a spec pair.
+     * returns: nullptr if the pair needs resampling or channel remixing
+     *          (or more than 8 channels), use convert_samples for those
+     */
+    inline ConvertFunction find_converter(const AudioSpec& from, const AudioSpec& to) noexcept {
+        if (from.freq != to.freq || from.channels != to.channels)
+            return nullptr;
+        if (from.channels < 1 || from.channels > convert::max_channels)
+            return nullptr;
+
+        const auto f = convert::index_of(from.format);
+        const auto t = convert::index_of(to.format);
+        if (f < 0 || t < 0)
+            return nullptr;
+        // the 512 format x format x channels converters, only odr-used by code that calls this
+        static constexpr auto converters = convert::table(std::make_index_sequence<convert::formats.size()>{});
+        return converters[f][t][from.channels - 1];
+    }
+
+    /**
+     * room convert_samples needs for src_len bytes of src_spec: an upper bound, not the size written.
+     * exact when both sides share the frequency. when resampling, SDL's output length depends on
+     * its filter, so this rounds up and adds one frame of slack,
+     * the exact count is what the convert_samples overloads return.
+     */
+    inline std::size_t converted_size(const AudioSpec& src_spec, const std::size_t src_len, const AudioSpec& dst_spec) noexcept {
+        const auto src_frame = static_cast<std::size_t>(src_spec.frame_size());
+        const auto dst_frame = static_cast<std::size_t>(dst_spec.frame_size());
+        if (src_frame == 0 || src_spec.freq <= 0 || dst_spec.freq <= 0)
+            return 0;
+
+        const auto frames = static_cast<Uint64>(src_len / src_frame);
+        if (src_spec.freq == dst_spec.freq)
+            return frames * dst_frame;
+
+        const auto src_freq = static_cast<Uint64>(src_spec.freq);
+        const auto dst_freq = static_cast<Uint64>(dst_spec.freq);
+        return ((frames * dst_freq + src_freq - 1) / src_freq + 1) * dst_frame;
+    }
+
+    /**
+     * reusable conversion context, owned by the caller.
+     * the SDL stream behind the resampling / remixing path is created the first time it is needed,
+     * then cleared between calls and switched to other spec pairs by retarget(),
+     * so converting many clips only costs the data copy.
+     */
+    struct AudioConverter {
+        AudioSpec
+            src_spec{};
+        AudioSpec
+            dst_spec{};
+        ConvertFunction
+            specialised{nullptr};
+        std::unique_ptr<AudioStream>
+            stream{};
+
+        // converts nothing until retarget()
+        AudioConverter() noexcept=default;
+
+        AudioConverter(const AudioSpec& src_spec, const AudioSpec& dst_spec) {
+            retarget(src_spec, dst_spec);
+        }
+
+        // switch to another spec pair, the stream is kept and only reformatted
+        void retarget(const AudioSpec& src, const AudioSpec& dst) {
+            if ((specialised || stream) && src == src_spec && dst == dst_spec)
+                return;
+            // members change only once the stream took the new pair, a throw leaves the old one usable
+            const auto converter = find_converter(src, dst);
+            if (!converter) {
+                if (stream)
+                    stream -> set_format(src, dst);
+                else
+                    stream = std::make_unique<AudioStream>(src, dst);
+            }
+            specialised = converter;
+            src_spec = src;
+            dst_spec = dst;
+        }
+
+        std::size_t size(const std::size_t src_len) const noexcept {
+            return converted_size(src_spec, src_len, dst_spec);
+        }
+
+        // returns: bytes written into dst
+        std::size_t operator () (const std::span<const std::byte> src, const std::span<std::byte> dst) {
+            if (dst.size() < size(src.size())) {
+                SDL_SetError("destination buffer too small: %zu < %zu", dst.size(), size(src.size()));
+                throw Error{};
+            }
+
+            if (!specialised && !stream) {
+                SDL_SetError("converter has no spec pair, retarget() it first");
+                throw Error{};
+            }
+            if (specialised) {
+                const auto frames = src.size() / src_spec.frame_size();
+                specialised(src.data(), dst.data(), frames);
+                return frames * dst_spec.frame_size();
+            }
+
+            stream -> clear();
+            stream -> put({reinterpret_cast<const unsigned char*>(src.data()), src.size()});
+            stream -> flush();
+
+            std::size_t written = 0;
+            while (written < dst.size()) {
+                const auto got = stream -> get({reinterpret_cast<unsigned char*>(dst.data()) + written, dst.size() - written});
+                if (got <= 0)
+                    break;
+                written += got;
+            }
+            return written;
+        }
+
+        // resize scratch to fit (keeping its capacity around) and convert into it
+        std::span<std::byte> operator () (const std::span<const std::byte> src, std::vector<std::byte>& scratch) {
+            scratch.resize(size(src.size()));
+            const auto written = (*this)(src, std::span{scratch});
+            return {scratch.data(), written};
+        }
+    };
+
+    /**
+     * convert into caller owned memory, nothing is allocated when only the sample format changes.
+     * resampling / remixing needs an SDL stream: these overloads create one per call,
+     * pass an AudioConverter (below) to reuse it across calls.
+     * returns: bytes written into dst
+     */
+    inline std::size_t convert_samples(const AudioSpec& src_spec, const std::span<const std::byte> src, const AudioSpec& dst_spec, const std::span<std::byte> dst) {
+        return AudioConverter{src_spec, dst_spec}(src, dst);
+    }
+
+    inline std::span<std::byte> convert_samples(const AudioSpec& src_spec, const std::span<const std::byte> src, const AudioSpec& dst_spec, std::vector<std::byte>& scratch) {
+        return AudioConverter{src_spec, dst_spec}(src, scratch);
+    }
+
+    // same, through the caller's context: no allocation after the first resampling call
+    inline std::size_t convert_samples(AudioConverter& converter, const AudioSpec& src_spec, const std::span<const std::byte> src, const AudioSpec& dst_spec, const std::span<std::byte> dst) {
+        converter.retarget(src_spec, dst_spec);
+        return converter(src, dst);
+    }
+
+    inline std::span<std::byte> convert_samples(AudioConverter& converter, const AudioSpec& src_spec, const std::span<const std::byte> src, const AudioSpec& dst_spec, std::vector<std::byte>& scratch) {
+        converter.retarget(src_spec, dst_spec);
+        return converter(src, scratch);
+    }
+}
+
+#endif //SDL_AUDIO_CONVERT_HPP
@@ -0,0 +1,711 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_EFFECT_HPP
+#define SDL_AUDIO_EFFECT_HPP
+#include "SDL_audio.hpp"
+#include "SDL_intrin.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace SDL {
+    enum class FilterType {
+        LOWPASS, HIGHPASS, BANDPASS, NOTCH, PEAKING, LOWSHELF, HIGHSHELF
+    };
+
+    namespace effect {
+        constexpr int max_channels = 8;
+        // frames per pass of the per-frame gain kernels, their scratch lives on the stack
+        constexpr std::size_t chunk_frames = 256;
+        // 20 * log10(2), dB per octave of amplitude
+        constexpr float db_per_log2 = 6.0205999f;
+
+        // log2 for x > 0, exponent from the bits, atanh series on the mantissa, error < 2e-5
+        inline float log2_fast(const float x) noexcept {
+            const auto bits = std::bit_cast<Uint32>(x);
+            const auto e = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+            const auto m = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u);
+            const auto t = (m - 1.0f) / (m + 1.0f), t2 = t * t;
+            return e + t * (2.8853901f + t2 * (0.9617967f + t2 * (0.5770780f + t2 * 0.4121986f)));
+        }
+
+        // 2^x, relative error < 1e-4
+        inline float exp2_fast(float x) noexcept {
+            x = std::clamp(x, -126.0f, 126.0f);
+            auto i = static_cast<int>(x);
+            i -= static_cast<float>(i) > x;
+            const auto f = x - static_cast<float>(i);
+            const auto p = 1.0f + f * (0.6931472f + f * (0.2402265f + f * (0.0555041f + f * (0.0096181f + f * 0.0013333f))));
+            return std::bit_cast<float>(static_cast<Uint32>(i + 127) << 23) * p;
+        }
+
+        // v[i] = log2_fast(v[i]), 4 at a time where the vector unit is there
+        inline void log2_block(float* v, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto mantissa = _mm_set1_epi32(0x007FFFFF), one_bits = _mm_set1_epi32(0x3F800000), bias = _mm_set1_epi32(127);
+            const auto one = _mm_set1_ps(1.0f);
+            for (; i + 4 <= n; i += 4) {
+                const auto bits = _mm_castps_si128(_mm_loadu_ps(v + i));
+                const auto e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+                const auto m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissa), one_bits));
+                const auto t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+                const auto t2 = _mm_mul_ps(t, t);
+                auto p = _mm_add_ps(_mm_set1_ps(0.5770780f), _mm_mul_ps(t2, _mm_set1_ps(0.4121986f)));
+                p = _mm_add_ps(_mm_set1_ps(0.9617967f), _mm_mul_ps(t2, p));
+                p = _mm_add_ps(_mm_set1_ps(2.8853901f), _mm_mul_ps(t2, p));
+                _mm_storeu_ps(v + i, _mm_add_ps(e, _mm_mul_ps(t, p)));
+            }
+#elif defined(SDL3PLUS_NEON)
+            const auto mantissa = vdupq_n_u32(0x007FFFFF), one_bits = vdupq_n_u32(0x3F800000), bias = vdupq_n_s32(127);
+            const auto one = vdupq_n_f32(1.0f);
+            for (; i + 4 <= n; i += 4) {
+                const auto bits = vreinterpretq_u32_f32(vld1q_f32(v + i));
+                const auto e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), bias));
+                const auto m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, mantissa), one_bits));
+                const auto t = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+                const auto t2 = vmulq_f32(t, t);
+                auto p = vmlaq_n_f32(vdupq_n_f32(0.5770780f), t2, 0.4121986f);
+                p = vmlaq_f32(vdupq_n_f32(0.9617967f), t2, p);
+                p = vmlaq_f32(vdupq_n_f32(2.8853901f), t2, p);
+                vst1q_f32(v + i, vmlaq_f32(e, t, p));
+            }
+#endif
+            for (; i < n; ++ i)
+                v[i] = log2_fast(v[i]);
+        }
+
+        // v[i] = exp2_fast(v[i])
+        inline void exp2_block(float* v, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto lo = _mm_set1_ps(-126.0f), hi = _mm_set1_ps(126.0f);
+            for (; i + 4 <= n; i += 4) {
+                const auto x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(v + i), lo), hi);
+                // truncation rounds negatives up, step those back down to the floor
+                auto k = _mm_cvttps_epi32(x);
+                k = _mm_add_epi32(k, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(k), x)));
+                const auto f = _mm_sub_ps(x, _mm_cvtepi32_ps(k));
+                auto p = _mm_add_ps(_mm_set1_ps(0.0096181f), _mm_mul_ps(f, _mm_set1_ps(0.0013333f)));
+                p = _mm_add_ps(_mm_set1_ps(0.0555041f), _mm_mul_ps(f, p));
+                p = _mm_add_ps(_mm_set1_ps(0.2402265f), _mm_mul_ps(f, p));
+                p = _mm_add_ps(_mm_set1_ps(0.6931472f), _mm_mul_ps(f, p));
+                p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+                const auto scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(k, _mm_set1_epi32(127)), 23));
+                _mm_storeu_ps(v + i, _mm_mul_ps(scale, p));
+            }
+#elif defined(SDL3PLUS_NEON)
+            const auto lo = vdupq_n_f32(-126.0f), hi = vdupq_n_f32(126.0f);
+            for (; i + 4 <= n; i += 4) {
+                const auto x = vminq_f32(vmaxq_f32(vld1q_f32(v + i), lo), hi);
+                const auto floor = vrndmq_f32(x);
+                const auto f = vsubq_f32(x, floor);
+                auto p = vmlaq_n_f32(vdupq_n_f32(0.0096181f), f, 0.0013333f);
+                p = vmlaq_f32(vdupq_n_f32(0.0555041f), f, p);
+                p = vmlaq_f32(vdupq_n_f32(0.2402265f), f, p);
+                p = vmlaq_f32(vdupq_n_f32(0.6931472f), f, p);
+                p = vmlaq_f32(vdupq_n_f32(1.0f), f, p);
+                const auto scale = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(floor), vdupq_n_s32(127)), 23));
+                vst1q_f32(v + i, vmulq_f32(scale, p));
+            }
+#endif
+            for (; i < n; ++ i)
+                v[i] = exp2_fast(v[i]);
+        }
+
+        // one pole smoothing coefficient reaching 1 - 1/e after `ms`, 0 means instant
+        inline float time_constant(const float ms, const int rate) noexcept {
+            return ms <= 0.0f ? 0.0f : std::exp(-1000.0f / (ms * static_cast<float>(rate)));
+        }
+
+        // normalized by a0
+        struct Coefficients {
+            float
+                b0{1.0f};
+            float
+                b1{0.0f};
+            float
+                b2{0.0f};
+            float
+                a1{0.0f};
+            float
+                a2{0.0f};
+        };
+
+        // Robert Bristow-Johnson's audio EQ cookbook
+        inline Coefficients design(const FilterType type, const float freq, const int rate, const float q, const float gain_db) noexcept {
+            const auto w = 2.0 * std::numbers::pi * std::clamp(static_cast<double>(freq), 1.0, SDL::max(0.49 * rate, 1.0)) / rate;
+            const auto cw = std::cos(w), sw = std::sin(w);
+            const auto alpha = sw / (2.0 * SDL::max(static_cast<double>(q), 1e-3));
+            const auto a = std::pow(10.0, gain_db / 40.0);
+
+            double b0, b1, b2, a0, a1, a2;
+            switch (type) {
+            case FilterType::LOWPASS:
+                b0 = (1 - cw) / 2; b1 = 1 - cw; b2 = (1 - cw) / 2;
+                a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+                break;
+            case FilterType::HIGHPASS:
+                b0 = (1 + cw) / 2; b1 = -(1 + cw); b2 = (1 + cw) / 2;
+                a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+                break;
+            case FilterType::BANDPASS:
+                b0 = alpha; b1 = 0; b2 = -alpha;
+                a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+                break;
+            case FilterType::NOTCH:
+                b0 = 1; b1 = -2 * cw; b2 = 1;
+                a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+                break;
+            case FilterType::PEAKING:
+                b0 = 1 + alpha * a; b1 = -2 * cw; b2 = 1 - alpha * a;
+                a0 = 1 + alpha / a; a1 = -2 * cw; a2 = 1 - alpha / a;
+                break;
+            case FilterType::LOWSHELF: {
+                const auto s = 2 * std::sqrt(a) * alpha;
+                b0 = a * ((a + 1) - (a - 1) * cw + s); b1 = 2 * a * ((a - 1) - (a + 1) * cw); b2 = a * ((a + 1) - (a - 1) * cw - s);
+                a0 = (a + 1) + (a - 1) * cw + s; a1 = -2 * ((a - 1) + (a + 1) * cw); a2 = (a + 1) + (a - 1) * cw - s;
+                break;
+            }
+            case FilterType::HIGHSHELF: {
+                const auto s = 2 * std::sqrt(a) * alpha;
+                b0 = a * ((a + 1) + (a - 1) * cw + s); b1 = -2 * a * ((a - 1) + (a + 1) * cw); b2 = a * ((a + 1) + (a - 1) * cw - s);
+                a0 = (a + 1) - (a - 1) * cw + s; a1 = 2 * ((a - 1) - (a + 1) * cw); a2 = (a + 1) - (a - 1) * cw - s;
+                break;
+            }
+            default:
+                return {};
+            }
+            return {
+                static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+                static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)
+            };
+        }
+
+#if defined(SDL3PLUS_SSE2)
+        using Lanes = __m128;
+
+        inline Lanes splat(const float v) noexcept {
+            return _mm_set1_ps(v);
+        }
+
+        // first N (1..4) floats, the rest zero
+        template<int N>
+        Lanes load(const float* p) noexcept {
+            if constexpr (N == 4)
+                return _mm_loadu_ps(p);
+            else if constexpr (N == 3)
+                return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p))), _mm_load_ss(p + 2));
+            else if constexpr (N == 2)
+                return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+            else
+                return _mm_load_ss(p);
+        }
+
+        template<int N>
+        void store(float* p, const Lanes v) noexcept {
+            if constexpr (N == 4)
+                _mm_storeu_ps(p, v);
+            else if constexpr (N == 3) {
+                _mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+                _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+            }
+            else if constexpr (N == 2)
+                _mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+            else
+                _mm_store_ss(p, v);
+        }
+
+        inline Lanes add(const Lanes a, const Lanes b) noexcept { return _mm_add_ps(a, b); }
+        inline Lanes sub(const Lanes a, const Lanes b) noexcept { return _mm_sub_ps(a, b); }
+        inline Lanes mul(const Lanes a, const Lanes b) noexcept { return _mm_mul_ps(a, b); }
+#elif defined(SDL3PLUS_NEON)
+        using Lanes = float32x4_t;
+
+        inline Lanes splat(const float v) noexcept {
+            return vdupq_n_f32(v);
+        }
+
+        template<int N>
+        Lanes load(const float* p) noexcept {
+            if constexpr (N == 4)
+                return vld1q_f32(p);
+            else if constexpr (N == 3)
+                return vcombine_f32(vld1_f32(p), vset_lane_f32(p[2], vdup_n_f32(0.0f), 0));
+            else if constexpr (N == 2)
+                return vcombine_f32(vld1_f32(p), vdup_n_f32(0.0f));
+            else
+                return vsetq_lane_f32(p[0], vdupq_n_f32(0.0f), 0);
+        }
+
+        template<int N>
+        void store(float* p, const Lanes v) noexcept {
+            if constexpr (N == 4)
+                vst1q_f32(p, v);
+            else if constexpr (N == 3) {
+                vst1_f32(p, vget_low_f32(v));
+                p[2] = vgetq_lane_f32(v, 2);
+            }
+            else if constexpr (N == 2)
+                vst1_f32(p, vget_low_f32(v));
+            else
+                p[0] = vgetq_lane_f32(v, 0);
+        }
+
+        inline Lanes add(const Lanes a, const Lanes b) noexcept { return vaddq_f32(a, b); }
+        inline Lanes sub(const Lanes a, const Lanes b) noexcept { return vsubq_f32(a, b); }
+        inline Lanes mul(const Lanes a, const Lanes b) noexcept { return vmulq_f32(a, b); }
+#endif
+
+#if defined(SDL3PLUS_SSE2) || defined(SDL3PLUS_NEON)
+        // channels [4 * G, 4 * G + 4) of a frame, the last group may be narrower
+        template<int Channels, int G>
+        constexpr int group_width = std::min(4, Channels - 4 * G);
+
+        /**
+         * transposed direct form II, one frame at a time with all channels of the frame in parallel:
+         * the recursion runs along time, so the lanes can only go across channels.
+         * the state stays in registers for the whole block
+         */
+        template<int Channels>
+        void biquad(const Coefficients& k, float* z1, float* z2, float* data, const std::size_t frames) noexcept {
+            constexpr int groups = (Channels + 3) / 4;
+            const auto b0 = splat(k.b0), b1 = splat(k.b1), b2 = splat(k.b2), a1 = splat(k.a1), a2 = splat(k.a2);
+
+            [&]<int... G>(std::integer_sequence<int, G...>) {
+                Lanes s1[groups] = {load<group_width<Channels, G>>(z1 + 4 * G)...};
+                Lanes s2[groups] = {load<group_width<Channels, G>>(z2 + 4 * G)...};
+
+                for (std::size_t i = 0; i < frames; ++ i) {
+                    const auto frame = data + i * Channels;
+                    ([&] {
+                        const auto x = load<group_width<Channels, G>>(frame + 4 * G);
+                        const auto y = add(mul(b0, x), s1[G]);
+                        s1[G] = add(sub(mul(b1, x), mul(a1, y)), s2[G]);
+                        s2[G] = sub(mul(b2, x), mul(a2, y));
+                        store<group_width<Channels, G>>(frame + 4 * G, y);
+                    }(), ...);
+                }
+
+                (store<group_width<Channels, G>>(z1 + 4 * G, s1[G]), ...);
+                (store<group_width<Channels, G>>(z2 + 4 * G, s2[G]), ...);
+            }(std::make_integer_sequence<int, groups>{});
+        }
+#else
+        template<int Channels>
+        void biquad(const Coefficients& k, float* z1, float* z2, float* data, const std::size_t frames) noexcept {
+            float s1[Channels], s2[Channels];
+            std::copy_n(z1, Channels, s1);
+            std::copy_n(z2, Channels, s2);
+            for (std::size_t i = 0; i < frames; ++ i)
+                for (int c = 0; c < Channels; ++ c) {
+                    const auto x = data[i * Channels + c];
+                    const auto y = k.b0 * x + s1[c];
+                    s1[c] = k.b1 * x - k.a1 * y + s2[c];
+                    s2[c] = k.b2 * x - k.a2 * y;
+                    data[i * Channels + c] = y;
+                }
+            std::copy_n(s1, Channels, z1);
+            std::copy_n(s2, Channels, z2);
+        }
+#endif
+
+        using BiquadFunction = void (*)(const Coefficients&, float*, float*, float*, std::size_t) noexcept;
+
+        template<std::size_t... N>
+        constexpr auto biquads(std::index_sequence<N...>) noexcept {
+            return std::array<BiquadFunction, max_channels>{&biquad<static_cast<int>(N) + 1>...};
+        }
+
+        // every sample of frame i times gains[i]
+        inline void apply_gains(float* data, const float* gains, const std::size_t frames, const int channels) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            if (channels == 1)
+                for (; i + 4 <= frames; i += 4)
+                    _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(gains + i)));
+            else if (channels == 2)
+                for (; i + 4 <= frames; i += 4) {
+                    const auto g = _mm_loadu_ps(gains + i);
+                    _mm_storeu_ps(data + 2 * i,     _mm_mul_ps(_mm_loadu_ps(data + 2 * i),     _mm_unpacklo_ps(g, g)));
+                    _mm_storeu_ps(data + 2 * i + 4, _mm_mul_ps(_mm_loadu_ps(data + 2 * i + 4), _mm_unpackhi_ps(g, g)));
+                }
+            else if (channels >= 4)
+                for (; i < frames; ++ i) {
+                    const auto g = _mm_set1_ps(gains[i]);
+                    auto* frame = data + i * channels;
+                    int c = 0;
+                    for (; c + 4 <= channels; c += 4)
+                        _mm_storeu_ps(frame + c, _mm_mul_ps(_mm_loadu_ps(frame + c), g));
+                    for (; c < channels; ++ c)
+                        frame[c] *= gains[i];
+                }
+#elif defined(SDL3PLUS_NEON)
+            if (channels == 1)
+                for (; i + 4 <= frames; i += 4)
+                    vst1q_f32(data + i, vmulq_f32(vld1q_f32(data + i), vld1q_f32(gains + i)));
+            else if (channels == 2)
+                for (; i + 4 <= frames; i += 4) {
+                    const auto g = vld1q_f32(gains + i);
+                    const auto pairs = vzipq_f32(g, g);
+                    vst1q_f32(data + 2 * i,     vmulq_f32(vld1q_f32(data + 2 * i),     pairs.val[0]));
+                    vst1q_f32(data + 2 * i + 4, vmulq_f32(vld1q_f32(data + 2 * i + 4), pairs.val[1]));
+                }
+            else if (channels >= 4)
+                for (; i < frames; ++ i) {
+                    auto* frame = data + i * channels;
+                    int c = 0;
+                    for (; c + 4 <= channels; c += 4)
+                        vst1q_f32(frame + c, vmulq_n_f32(vld1q_f32(frame + c), gains[i]));
+                    for (; c < channels; ++ c)
+                        frame[c] *= gains[i];
+                }
+#endif
+            for (; i < frames; ++ i)
+                for (int c = 0; c < channels; ++ c)
+                    data[i * channels + c] *= gains[i];
+        }
+
+        inline void scale(float* data, const float gain, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto g = _mm_set1_ps(gain);
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+#elif defined(SDL3PLUS_NEON)
+            for (; i + 4 <= n; i += 4)
+                vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), gain));
+#endif
+            for (; i < n; ++ i)
+                data[i] *= gain;
+        }
+
+        // below 3 Hz no filter frequency fits under nyquist
+        inline bool supported(const AudioSpec& spec) noexcept {
+            return spec.channels >= 1 && spec.channels <= max_channels && spec.freq >= 3;
+        }
+    }
+
+    /**
+     * one biquad section per channel, RBJ designs.
+     * parameters may change between any two blocks (set() only flags them,
+     * the coefficients are recomputed on the next block at that block's rate),
+     * the filter state is kept so the change does not click. cascade several for steeper slopes
+     */
+    struct BiquadFilter {
+        FilterType
+            type{FilterType::LOWPASS};
+        float
+            freq{1000.0f};
+        float
+            q{std::numbers::sqrt2_v<float> / 2};
+        // PEAKING / LOWSHELF / HIGHSHELF only
+        float
+            gain_db{0.0f};
+
+        effect::Coefficients
+            coefficients{};
+        int
+            designed_rate{0};
+        bool
+            dirty{true};
+        alignas(16) float
+            z1[effect::max_channels]{};
+        alignas(16) float
+            z2[effect::max_channels]{};
+
+        BiquadFilter()=default;
+        BiquadFilter(const FilterType type, const float freq, const float q=std::numbers::sqrt2_v<float> / 2, const float gain_db=0.0f) noexcept:
+            type{type},
+            freq{freq},
+            q{q},
+            gain_db{gain_db} {}
+
+        void set(const FilterType new_type, const float new_freq, const float new_q, const float new_gain_db=0.0f) noexcept {
+            type = new_type;
+            freq = new_freq;
+            q = new_q;
+            gain_db = new_gain_db;
+            dirty = true;
+        }
+
+        void reset() noexcept {
+            std::fill_n(z1, effect::max_channels, 0.0f);
+            std::fill_n(z2, effect::max_channels, 0.0f);
+        }
+
+        void operator () (const AudioSpec& spec, const std::span<float> samples) noexcept {
+            if (!effect::supported(spec))
+                return;
+            if (dirty || designed_rate != spec.freq) {
+                coefficients = effect::design(type, freq, spec.freq, q, gain_db);
+                designed_rate = spec.freq;
+                dirty = false;
+            }
+
+            static constexpr auto table = effect::biquads(std::make_index_sequence<effect::max_channels>{});
+            table[spec.channels - 1](coefficients, z1, z2, samples.data(), samples.size() / spec.channels);
+
+            // a decayed tail would otherwise keep the next silent block in denormals
+            for (int c = 0; c < spec.channels; ++ c) {
+                if (std::abs(z1[c]) < 1e-20f) z1[c] = 0.0f;
+                if (std::abs(z2[c]) < 1e-20f) z2[c] = 0.0f;
+            }
+        }
+    };
+
+    /**
+     * feed-forward compressor, channels linked on their peak.
+     * the gain computer (soft knee) and the attack / release smoothing run in dB per frame,
+     * the conversions in and out of dB use the vectorized log2 / exp2 above
+     * and the gains are applied to the frames in a vector pass.
+     * every parameter is read at the start of a block, change them freely between blocks
+     */
+    struct Compressor {
+        float
+            threshold_db{-12.0f};
+        // infinity makes a limiter
+        float
+            ratio{4.0f};
+        float
+            knee_db{6.0f};
+        float
+            attack_ms{5.0f};
+        float
+            release_ms{80.0f};
+        float
+            makeup_db{0.0f};
+
+        // current gain reduction, <= 0
+        float
+            reduction_db{0.0f};
+
+        /**
+         * brick wall at `ceiling_db` without look-ahead: instant attack, no knee,
+         * so no frame leaves louder than the ceiling (give or take the 1e-4 of exp2_fast)
+         */
+        static Compressor limiter(const float ceiling_db=-0.3f, const float release_ms=50.0f) noexcept {
+            return {ceiling_db, std::numeric_limits<float>::infinity(), 0.0f, 0.0f, release_ms, 0.0f};
+        }
+
+        void reset() noexcept {
+            reduction_db = 0.0f;
+        }
+
+        void operator () (const AudioSpec& spec, const std::span<float> samples) noexcept {
+            if (!effect::supported(spec))
+                return;
+            const auto channels = spec.channels;
+            const auto frames = samples.size() / channels;
+
+            const auto slope = std::isinf(ratio) ? -1.0f : 1.0f / SDL::max(ratio, 1.0f) - 1.0f;
+            const auto knee = SDL::max(knee_db, 0.0f);
+            const auto attack = effect::time_constant(attack_ms, spec.freq);
+            const auto release = effect::time_constant(release_ms, spec.freq);
+            const auto to_log2 = 1.0f / effect::db_per_log2;
+            const auto makeup = makeup_db * to_log2;
+            // quadratic knee, (over + knee / 2)^2 / (2 knee)
+            const auto knee_scale = knee > 0.0f ? 0.5f / knee : 0.0f;
+
+            // detector, dB, gain computer and the exp back are separate passes over the chunk,
+            // only the smoothing is a true recursion, the rest runs 4 frames at a time
+            float gains[effect::chunk_frames];
+            for (std::size_t begin = 0; begin < frames; begin += effect::chunk_frames) {
+                const auto n = SDL::min(effect::chunk_frames, frames - begin);
+                auto* data = samples.data() + begin * channels;
+
+                for (std::size_t i = 0; i < n; ++ i) {
+                    auto peak = 1e-9f;
+                    for (int c = 0; c < channels; ++ c)
+                        peak = SDL::max(peak, std::abs(data[i * channels + c]));
+                    gains[i] = peak;
+                }
+                effect::log2_block(gains, n);
+
+                // branch free, and state * k + target * (1 - k) keeps the loop carried chain to one multiply-add
+                auto state = reduction_db;
+                for (std::size_t i = 0; i < n; ++ i) {
+                    const auto over = gains[i] * effect::db_per_log2 - threshold_db;
+                    const auto x = std::clamp(over + knee / 2.0f, 0.0f, knee);
+                    const auto target = slope * (x * x * knee_scale + SDL::max(over - knee / 2.0f, 0.0f));
+
+                    const auto attacking = target < state;
+                    state = (attacking ? attack : release) * state + (attacking ? 1.0f - attack : 1.0f - release) * target;
+                    gains[i] = state * to_log2 + makeup;
+                }
+                reduction_db = state;
+
+                effect::exp2_block(gains, n);
+                effect::apply_gains(data, gains, n, channels);
+            }
+        }
+    };
+
+    /**
+     * gain that moves to a new value over `ramp_ms` instead of jumping (no zipper noise).
+     * set() may be called every block, the ramp restarts from wherever the gain currently is
+     */
+    struct GainRamp {
+        float
+            current{1.0f};
+        float
+            target{1.0f};
+        float
+            ramp_ms{20.0f};
+
+        float
+            step{0.0f};
+        std::size_t
+            remaining{0};
+        bool
+            pending{false};
+
+        GainRamp()=default;
+        explicit GainRamp(const float gain, const float ramp_ms=20.0f) noexcept:
+            current{gain},
+            target{gain},
+            ramp_ms{ramp_ms} {}
+
+        void set(const float gain) noexcept {
+            target = gain;
+            pending = true;
+        }
+
+        // no ramp
+        void jump(const float gain) noexcept {
+            current = target = gain;
+            remaining = 0;
+            pending = false;
+        }
+
+        void operator () (const AudioSpec& spec, const std::span<float> samples) noexcept {
+            if (!effect::supported(spec))
+                return;
+            const auto channels = spec.channels;
+            const auto frames = samples.size() / channels;
+
+            if (pending) {
+                remaining = SDL::max<std::size_t>(static_cast<std::size_t>(ramp_ms * static_cast<float>(spec.freq) / 1000.0f), 1);
+                step = (target - current) / static_cast<float>(remaining);
+                pending = false;
+            }
+
+            std::size_t i = 0;
+            float gains[effect::chunk_frames];
+            while (remaining > 0 && i < frames) {
+                const auto n = SDL::min(SDL::min(effect::chunk_frames, frames - i), remaining);
+                for (std::size_t j = 0; j < n; ++ j)
+                    gains[j] = current + step * static_cast<float>(j + 1);
+                effect::apply_gains(samples.data() + i * channels, gains, n, channels);
+
+                remaining -= n;
+                current = remaining == 0 ? target : gains[n - 1];
+                i += n;
+            }
+
+            if (i < frames && current != 1.0f)
+                effect::scale(samples.data() + i * channels, current, (frames - i) * channels);
+        }
+    };
+
+    /**
+     * stages run in order on interleaved F32 blocks, composed at compile time:
+     * no virtual call and no allocation per block, stages are reached with get<I>() / get<T>()
+     * to change their parameters.
+     *
+     * the chain is itself an effect `void(const AudioSpec&, std::span<float>)`,
+     * so it goes straight into BusGraph::add_effect (pass std::ref(chain) to keep configuring it).
+     * pull() / push() plug it into a stream pair through the get / put callbacks,
+     * it must then stay in place and outlive the callback.
+     * stage parameters are not atomic: change them from the audio thread,
+     * or while holding the lock of the stream / graph that runs the chain
+     */
+    template<typename... Stages>
+    requires (std::invocable<Stages&, const AudioSpec&, std::span<float>> && ...)
+    struct EffectChain {
+        std::tuple<Stages...>
+            stages;
+        // F32 spec the stream plugs run the chain in
+        AudioSpec
+            spec{};
+        std::vector<float>
+            staging;
+
+        EffectChain()=default;
+        explicit EffectChain(Stages... stages):
+            stages{std::move(stages)...} {}
+
+        template<std::size_t I>
+        auto& get() noexcept {
+            return std::get<I>(stages);
+        }
+
+        template<typename T>
+        T& get() noexcept {
+            return std::get<T>(stages);
+        }
+
+        void operator () (const AudioSpec& block_spec, const std::span<float> samples) noexcept {
+            std::apply([&](auto&... stage) {
+                (stage(block_spec, samples), ...);
+            }, stages);
+        }
+
+        /**
+         * output side: when `output` asks for data, pull it from `source`, run the chain, put it into `output`.
+         * source's output spec must be F32 and equal to output's input spec.
+         * both streams must outlive the callback
+         */
+        void pull(AudioStream& output, AudioStream& source, const std::size_t block_frames=1024) {
+            prepare(source.format().second, output.format().first, block_frames);
+            output.add_callback_get([this, from = &source](AudioStream& to, int additional, int) noexcept {
+                while (additional > 0) {
+                    const auto want = SDL::min(additional, static_cast<int>(staging.size() * sizeof(float)));
+                    const auto got = SDL_GetAudioStreamData(from -> handle, staging.data(), want);
+                    if (got <= 0)
+                        break;
+                    run(to, got);
+                    additional -= got;
+                }
+            });
+        }
+
+        /**
+         * recording side: whatever arrives in `input` is taken out, run through the chain and put into `sink`.
+         * input's output spec must be F32 and equal to sink's input spec.
+         * both streams must outlive the callback
+         */
+        void push(AudioStream& input, AudioStream& sink, const std::size_t block_frames=1024) {
+            prepare(input.format().second, sink.format().first, block_frames);
+            input.add_callback_put([this, to = &sink](AudioStream& from, int, int) noexcept {
+                for (int got; (got = SDL_GetAudioStreamData(from.handle, staging.data(), static_cast<int>(staging.size() * sizeof(float)))) > 0;)
+                    run(*to, got);
+            });
+        }
+
+        void prepare(const AudioSpec& from, const AudioSpec& to, const std::size_t block_frames) {
+            if (from.format != AudioFormat::F32 || from != to || !effect::supported(from) || block_frames == 0) {
+                SDL_SetError("effect chains run on F32 streams with matching specs");
+                throw Error{};
+            }
+            spec = from;
+            staging.resize(block_frames * static_cast<std::size_t>(spec.channels));
+        }
+
+        void run(AudioStream& to, const int bytes) noexcept {
+            (*this)(spec, {staging.data(), static_cast<std::size_t>(bytes) / sizeof(float)});
+            SDL_PutAudioStreamData(to.handle, staging.data(), bytes);
+        }
+    };
+}
+
+#endif //SDL_AUDIO_EFFECT_HPP
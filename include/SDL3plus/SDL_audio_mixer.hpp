@@ -0,0 +1,170 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_MIXER_HPP
+#define SDL_AUDIO_MIXER_HPP
+#include "SDL_audio.hpp"
+#include "SDL_intrin.hpp"
+#include <cmath>
+#include <span>
+
+namespace SDL {
+    struct MixSource {
+        std::span<const Uint8>
+            data;
+        float
+            gain{1.0f};
+    };
+
+    namespace mixer {
+        // samples per tile, the accumulator stays in L1 while every source is added
+        constexpr std::size_t tile_size = 1024;
+
+        inline void load_f32(float* acc, const float* src, const std::size_t n) noexcept {
+            std::copy_n(src, n, acc);
+        }
+
+        inline void accumulate_f32(float* acc, const float* src, const float gain, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto g = _mm_set1_ps(gain);
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#elif defined(SDL3PLUS_NEON)
+            const auto g = vdupq_n_f32(gain);
+            for (; i + 4 <= n; i += 4)
+                vst1q_f32(acc + i, vmlaq_f32(vld1q_f32(acc + i), vld1q_f32(src + i), g));
+#endif
+            for (; i < n; ++ i)
+                acc[i] += src[i] * gain;
+        }
+
+        inline void store_f32(float* dst, const float* acc, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto lo = _mm_set1_ps(-1.0f);
+            const auto hi = _mm_set1_ps(1.0f);
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i), lo), hi));
+#elif defined(SDL3PLUS_NEON)
+            const auto lo = vdupq_n_f32(-1.0f);
+            const auto hi = vdupq_n_f32(1.0f);
+            for (; i + 4 <= n; i += 4)
+                vst1q_f32(dst + i, vminq_f32(vmaxq_f32(vld1q_f32(acc + i), lo), hi));
+#endif
+            for (; i < n; ++ i)
+                dst[i] = std::clamp(acc[i], -1.0f, 1.0f);
+        }
+
+        inline void load_s16(float* acc, const Sint16* src, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            for (; i + 8 <= n; i += 8) {
+                const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_storeu_ps(acc + i,     _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)));
+                _mm_storeu_ps(acc + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)));
+            }
+#elif defined(SDL3PLUS_NEON)
+            for (; i + 8 <= n; i += 8) {
+                const auto v = vld1q_s16(src + i);
+                vst1q_f32(acc + i,     vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+                vst1q_f32(acc + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+            }
+#endif
+            for (; i < n; ++ i)
+                acc[i] = static_cast<float>(src[i]);
+        }
+
+        inline void accumulate_s16(float* acc, const Sint16* src, const float gain, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto g = _mm_set1_ps(gain);
+            for (; i + 8 <= n; i += 8) {
+                const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                const auto l = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+                const auto h = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+                _mm_storeu_ps(acc + i,     _mm_add_ps(_mm_loadu_ps(acc + i),     _mm_mul_ps(l, g)));
+                _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(h, g)));
+            }
+#elif defined(SDL3PLUS_NEON)
+            const auto g = vdupq_n_f32(gain);
+            for (; i + 8 <= n; i += 8) {
+                const auto v = vld1q_s16(src + i);
+                vst1q_f32(acc + i,     vmlaq_f32(vld1q_f32(acc + i),     vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))),  g));
+                vst1q_f32(acc + i + 4, vmlaq_f32(vld1q_f32(acc + i + 4), vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), g));
+            }
+#endif
+            for (; i < n; ++ i)
+                acc[i] += static_cast<float>(src[i]) * gain;
+        }
+
+        // saturating
+        inline void store_s16(Sint16* dst, const float* acc, const std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            // cvtps rounds to nearest, packs saturates to [-32768, 32767]
+            // (out of int32 range gives 0x80000000 which saturates to -32768, so clamp first)
+            const auto lo = _mm_set1_ps(-32768.0f);
+            const auto hi = _mm_set1_ps(32767.0f);
+            for (; i + 8 <= n; i += 8) {
+                const auto l = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i),     lo), hi));
+                const auto h = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i + 4), lo), hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(l, h));
+            }
+#elif defined(SDL3PLUS_NEON)
+            for (; i + 8 <= n; i += 8) {
+                const auto l = vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(acc + i)));
+                const auto h = vqmovn_s32(vcvtnq_s32_f32(vld1q_f32(acc + i + 4)));
+                vst1q_s16(dst + i, vcombine_s16(l, h));
+            }
+#endif
+            for (; i < n; ++ i)
+                dst[i] = static_cast<Sint16>(std::lrint(std::clamp(acc[i], -32768.0f, 32767.0f)));
+        }
+
+        template<typename T, auto load, auto accumulate, auto store>
+        void mix_tiled(const std::span<Uint8> dst, const std::span<const MixSource> sources) noexcept {
+            alignas(16) float acc[tile_size];
+
+            const auto out = reinterpret_cast<T*>(dst.data());
+            const auto total = dst.size() / sizeof(T);
+
+            for (std::size_t beg = 0; beg < total; beg += tile_size) {
+                const auto n = SDL::min(tile_size, total - beg);
+                load(acc, out + beg, n);
+
+                for (const auto& [data, gain]: sources) {
+                    const auto len = data.size() / sizeof(T);
+                    if (len <= beg || gain == 0.0f)
+                        continue;
+                    accumulate(acc, reinterpret_cast<const T*>(data.data()) + beg, gain, SDL::min(n, len - beg));
+                }
+
+                store(out + beg, acc, n);
+            }
+        }
+    }
+
+    /**
+     * mix every source into dst in a single pass, dst[i] = clamp(dst[i] + sum(src[i] * gain))
+     * sources shorter than dst only contribute to the head of dst.
+     *
+     * native S16 and F32 go through the tiled kernels above,
+     * clipping happens once after all sources are summed.
+     * any other format falls back to one SDL_MixAudio pass per source.
+     */
+    inline void mix_audio(const std::span<Uint8> dst, const std::span<const MixSource> sources, const AudioFormat format) {
+        switch (format) {
+        case AudioFormat::F32:
+            return mixer::mix_tiled<float, mixer::load_f32, mixer::accumulate_f32, mixer::store_f32>(dst, sources);
+        case AudioFormat::S16:
+            return mixer::mix_tiled<Sint16, mixer::load_s16, mixer::accumulate_s16, mixer::store_s16>(dst, sources);
+        default:
+            for (const auto& [data, gain]: sources)
+                mix_audio(dst.data(), data.data(), format, static_cast<Uint32>(SDL::min(dst.size(), data.size())), gain);
+        }
+    }
+}
+
+#endif //SDL_AUDIO_MIXER_HPP
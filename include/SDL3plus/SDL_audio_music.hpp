@@ -0,0 +1,269 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_MUSIC_HPP
+#define SDL_AUDIO_MUSIC_HPP
+#include "SDL_asyncio.hpp"
+#include "SDL_audio.hpp"
+#include "SDL_audio_wav.hpp"
+#include <atomic>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace SDL {
+    /**
+     * streaming .wav source fed by async reads, the non-blocking counterpart of WavStream.
+     *
+     * the pcm is read `chunk_size` bytes at a time into a ring of `depth` buffers,
+     * every free buffer always has a read in flight on the stream's own TaskQueue.
+     * the get-callback only polls that queue (SDL_GetAsyncIOResult, no wait),
+     * hands completed buffers to the AudioStream in file order and resubmits them,
+     * so the audio thread never waits for the disk. when SDL asks for more
+     * than what has landed, the callback counts as dry and SDL plays silence for the gap.
+     * the constructor reads the header and waits for the first chunk, so playback starts primed.
+     *
+     * the input format of the AudioStream is switched to the file's spec,
+     * the AudioStream must outlive the MusicStream.
+     */
+    struct MusicStream {
+        enum class State: Uint8 {
+            FREE, PENDING, READY
+        };
+
+        struct Buffer {
+            std::byte*
+                data;
+            // pcm range read into data, `bytes` of it landed so far
+            Uint64
+                offset{0};
+            Uint64
+                size{0};
+            Uint64
+                bytes{0};
+            // seek() bumps the epoch, reads of an older one are thrown away when they land
+            Uint64
+                epoch{0};
+            State
+                state{State::FREE};
+            bool
+                failed{false};
+        };
+
+        AudioStream&
+            stream;
+        // declared before the task, the queue outlives the close the task queues on destruction
+        AsyncIO::TaskQueue
+            queue;
+        // file handle, its buffer is the ring's memory
+        AsyncIO::Task
+            file;
+        AudioSpec
+            spec{};
+        Uint64
+            data_begin{0};
+        Uint64
+            data_size{0};
+        std::size_t
+            chunk_size;
+        bool
+            loop;
+
+        // audio thread (or under the stream lock) from here
+        std::vector<Buffer>
+            ring;
+        std::size_t
+            play_index{0};
+        std::size_t
+            read_index{0};
+        // next pcm byte to request
+        Uint64
+            read_cursor{0};
+        std::size_t
+            in_flight{0};
+        Uint64
+            epoch{0};
+        bool
+            end_requested{false};
+
+        std::atomic_bool
+            finished{false};
+        // callbacks that wanted more than had landed
+        std::atomic<Uint64>
+            dry{0};
+
+        MusicStream(const std::filesystem::path& path, AudioStream& stream, const std::size_t chunk_size=64 * 1024, const std::size_t depth=3, const bool loop=false):
+            stream{stream},
+            file{queue, SDL::max<std::size_t>(depth, 2) * SDL::max<std::size_t>(chunk_size, wav::riff_header_size + 40), AsyncIO::Task::fromFile(path, AsyncIO::Task::OpenMode::READ)},
+            chunk_size{chunk_size},
+            loop{loop} {
+            parse();
+            // whole frames only
+            this->chunk_size = SDL::max<std::size_t>(chunk_size / spec.frame_size(), 1) * spec.frame_size();
+
+            ring.resize(SDL::max<std::size_t>(depth, 2));
+            for (std::size_t i = 0; i < ring.size(); ++ i)
+                ring[i].data = file.buffer + i * this->chunk_size;
+
+            stream.set_format(spec, stream.format().second);
+            submit();
+            prime();
+            stream.add_callback_get(on_get, this);
+        }
+
+        MusicStream(const MusicStream&)=delete;
+        MusicStream& operator = (const MusicStream&)=delete;
+
+        // the reads still in flight write into the ring, wait for them before it goes
+        ~MusicStream() noexcept {
+            SDL_SetAudioStreamGetCallback(stream.handle, nullptr, nullptr);
+            AsyncIO::Outcome outcome;
+            while (in_flight > 0 && queue.wait(outcome))
+                if (outcome.type == AsyncIO::TaskType::READ)
+                    -- in_flight;
+                else
+                    AsyncIO::Completion::dispatch(outcome);
+        }
+
+        // seek to a frame, audio already queued in the AudioStream still plays
+        void seek(const Uint64 frame) {
+            stream.lock();
+            ++ epoch;
+            for (auto& buffer: ring)
+                if (buffer.state == State::READY)
+                    buffer.state = State::FREE;
+            play_index = read_index;
+            read_cursor = SDL::min(frame * spec.frame_size(), data_size);
+            end_requested = false;
+            finished = false;
+            submit();
+            stream.unlock();
+        }
+
+        // blocking read, constructor only
+        void fetch(std::byte* dst, const Uint64 offset, const Uint64 size) {
+            if (!file.read_into(dst, offset, size))
+                throw Error{};
+            AsyncIO::Outcome outcome;
+            if (!queue.wait(outcome))
+                throw Error{};
+            if (outcome.result != AsyncIO::Result::COMPLETE || outcome.bytes_transferred != size) {
+                SDL_SetError("unexpected end of WAVE file");
+                throw Error{};
+            }
+        }
+
+        void parse() {
+            const auto layout = wav::locate([this](std::byte* const dst, const Uint64 offset, const Uint64 size) {
+                fetch(dst, offset, size);
+            }, static_cast<Uint64>(file.size()));
+            spec = layout.spec;
+            data_begin = layout.data_begin;
+            data_size = layout.data_size;
+        }
+
+        // waits for the first chunk, the first callback then has something to play
+        void prime() {
+            AsyncIO::Outcome outcome;
+            while (in_flight > 0 && ring[play_index].state == State::PENDING && queue.wait(outcome))
+                land(outcome);
+        }
+
+        // a read on every free buffer, in ring order
+        void submit() noexcept {
+            while (!end_requested && ring[read_index].state == State::FREE) {
+                if (read_cursor == data_size) {
+                    if (!loop || data_size == 0) {
+                        end_requested = true;
+                        return;
+                    }
+                    read_cursor = 0;
+                }
+
+                auto& buffer = ring[read_index];
+                const auto n = SDL::min<Uint64>(chunk_size, data_size - read_cursor);
+                if (!file.read_into(buffer.data, data_begin + read_cursor, n, &buffer)) {
+                    end_requested = true;
+                    return;
+                }
+                buffer.state = State::PENDING;
+                buffer.epoch = epoch;
+                buffer.failed = false;
+                buffer.offset = read_cursor;
+                buffer.size = n;
+                buffer.bytes = 0;
+                read_cursor += n;
+                ++ in_flight;
+                read_index = (read_index + 1) % ring.size();
+            }
+        }
+
+        void land(const AsyncIO::Outcome& outcome) noexcept {
+            if (outcome.type != AsyncIO::TaskType::READ) {
+                AsyncIO::Completion::dispatch(outcome);
+                return;
+            }
+            -- in_flight;
+            auto& buffer = *outcome.userdata<Buffer>();
+            if (buffer.epoch != epoch) {
+                buffer.state = State::FREE;
+                return;
+            }
+
+            const auto got = SDL::min(outcome.bytes_transferred, buffer.size - buffer.bytes);
+            if (outcome.result != AsyncIO::Result::COMPLETE || got == 0) {
+                buffer.failed = true;
+                buffer.state = State::READY;
+                return;
+            }
+            buffer.bytes += got;
+
+            // a short read asks for the rest of the range and stays pending, so no audio is skipped
+            if (buffer.bytes < buffer.size) {
+                const auto rest = buffer.bytes;
+                if (!file.read_into(buffer.data + rest, data_begin + buffer.offset + rest, buffer.size - rest, &buffer)) {
+                    buffer.failed = true;
+                    buffer.state = State::READY;
+                    return;
+                }
+                ++ in_flight;
+                return;
+            }
+            buffer.state = State::READY;
+        }
+
+        // audio thread
+        void pump(int wanted) noexcept {
+            AsyncIO::Outcome outcome;
+            while (queue.get(outcome))
+                land(outcome);
+
+            while (wanted > 0 && ring[play_index].state == State::READY) {
+                auto& buffer = ring[play_index];
+                if (buffer.failed) {
+                    end_requested = true;
+                    finished = true;
+                    return;
+                }
+                SDL_PutAudioStreamData(stream.handle, buffer.data, static_cast<int>(buffer.bytes));
+                wanted -= static_cast<int>(buffer.bytes);
+                buffer.state = State::FREE;
+                play_index = (play_index + 1) % ring.size();
+            }
+
+            if (end_requested && in_flight == 0 && ring[play_index].state == State::FREE)
+                finished = true;
+            else if (wanted > 0)
+                dry.fetch_add(1, std::memory_order_relaxed);
+
+            submit();
+        }
+
+        static void SDLCALL on_get(void* userdata, SDL_AudioStream*, const int additional_amount, int) noexcept {
+            static_cast<MusicStream*>(userdata) -> pump(additional_amount);
+        }
+    };
+}
+
+#endif //SDL_AUDIO_MUSIC_HPP
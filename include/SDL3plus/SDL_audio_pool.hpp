@@ -0,0 +1,224 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_POOL_HPP
+#define SDL_AUDIO_POOL_HPP
+#include "SDL_audio.hpp"
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace SDL {
+    /**
+     * recycles streams for short-lived sounds.
+     *
+     * streams are created per (src spec, dst spec) pair, bound to the device once
+     * and stay bound for the pool's life: an idle stream is just an empty one, the device skips it.
+     * acquire() hands out a cleared stream with unity gain and ratio,
+     * play() is the one-shot form: the clip is queued and flushed and the stream comes back by itself
+     * once SDL drained it (checked by reclaim(), which acquire() runs before growing a group).
+     * streams acquired by hand go back with release().
+     * with reserve() sized for the peak, steady state creates and destroys nothing.
+     */
+    struct AudioStreamPool {
+        struct Stats {
+            Uint64
+                created;
+            Uint64
+                reused;
+            Uint64
+                reclaimed;
+        };
+
+        struct Lease {
+            AudioStream*
+                stream;
+            // queued and flushed by play(), reclaimed once drained
+            bool
+                oneshot;
+        };
+
+        struct Group {
+            AudioSpec
+                src;
+            AudioSpec
+                dst;
+            std::vector<std::unique_ptr<AudioStream>>
+                streams{};
+            std::vector<AudioStream*>
+                idle{};
+            std::vector<Lease>
+                busy{};
+        };
+
+        AudioDevice&
+            device;
+        std::vector<Group>
+            groups;
+        Stats
+            counters{};
+        std::mutex
+            lock;
+
+        explicit AudioStreamPool(AudioDevice& device) noexcept:
+            device{device} {}
+
+        AudioStreamPool(const AudioStreamPool&)=delete;
+        AudioStreamPool& operator = (const AudioStreamPool&)=delete;
+
+        // create and bind streams up front until the pair has at least count of them
+        void reserve(const AudioSpec& src, const AudioSpec& dst, const std::size_t count) {
+            auto guard = std::scoped_lock{lock};
+            auto& group = find(src, dst);
+            if (group.streams.size() < count)
+                grow(group, count - group.streams.size());
+        }
+
+        AudioStream& acquire(const AudioSpec& src, const AudioSpec& dst) {
+            auto guard = std::scoped_lock{lock};
+            return *take(find(src, dst), false);
+        }
+
+        // dst is the device's own format
+        AudioStream& acquire(const AudioSpec& src) {
+            return acquire(src, device.format().first);
+        }
+
+        /**
+         * queue a whole clip on a pooled stream and let the pool take it back when it finished playing.
+         * the returned stream may be used to tweak gain / ratio until then, not after.
+         */
+        AudioStream& play(const AudioSpec& src, const std::span<const unsigned char> data, const float gain=1.0f) {
+            const auto dst = device.format().first;
+            auto guard = std::scoped_lock{lock};
+            auto& stream = *take(find(src, dst), true);
+            try {
+                if (gain != 1.0f)
+                    stream.gain(gain);
+                stream.put(data);
+                stream.flush();
+            }
+            catch (...) {
+                give_back(stream);
+                throw;
+            }
+            return stream;
+        }
+
+        void release(AudioStream& stream) {
+            auto guard = std::scoped_lock{lock};
+            give_back(stream);
+        }
+
+        // return every drained one-shot stream, returns: how many
+        std::size_t reclaim() {
+            auto guard = std::scoped_lock{lock};
+            std::size_t n = 0;
+            for (auto& group: groups)
+                n += reclaim(group);
+            return n;
+        }
+
+        Stats stats() {
+            auto guard = std::scoped_lock{lock};
+            return counters;
+        }
+
+        // lock held for every function below
+
+        Group& find(const AudioSpec& src, const AudioSpec& dst) {
+            for (auto& group: groups)
+                if (group.src == src && group.dst == dst)
+                    return group;
+            return groups.emplace_back(Group{src, dst});
+        }
+
+        void grow(Group& group, const std::size_t count) {
+            auto handles = std::vector<SDL_AudioStream*>{};
+            handles.reserve(count);
+            group.streams.reserve(group.streams.size() + count);
+            group.idle.reserve(group.streams.size() + count);
+            group.busy.reserve(group.streams.size() + count);
+
+            // a failed creation or bind destroys what this call created
+            const auto first = group.streams.size();
+            try {
+                for (std::size_t i = 0; i < count; ++ i) {
+                    auto& stream = group.streams.emplace_back(std::make_unique<AudioStream>(group.src, group.dst));
+                    handles.push_back(stream -> handle);
+                }
+                AudioStream::bind(device, handles);
+            }
+            catch (...) {
+                group.streams.resize(first);
+                throw;
+            }
+            counters.created += count;
+            for (auto i = first; i < group.streams.size(); ++ i)
+                group.idle.push_back(group.streams[i].get());
+        }
+
+        AudioStream* take(Group& group, const bool oneshot) {
+            if (group.idle.empty())
+                reclaim(group);
+            if (group.idle.empty())
+                grow(group, SDL::max<std::size_t>(group.streams.size() / 2, 1));
+            else
+                ++ counters.reused;
+
+            const auto stream = group.idle.back();
+            group.idle.pop_back();
+            group.busy.push_back({stream, oneshot});
+            return stream;
+        }
+
+        // streams are reset on the way back, an idle stream is always empty and silent
+        void give_back(AudioStream& stream) noexcept {
+            for (auto& group: groups)
+                for (auto it = group.busy.begin(); it != group.busy.end(); ++ it)
+                    if (it -> stream == &stream) {
+                        recycle(stream);
+                        group.busy.erase(it);
+                        group.idle.push_back(&stream);
+                        return;
+                    }
+        }
+
+        std::size_t reclaim(Group& group) noexcept {
+            const auto drained = [](const AudioStream& stream) noexcept {
+                return SDL_GetAudioStreamQueued(stream.handle) == 0 && SDL_GetAudioStreamAvailable(stream.handle) == 0;
+            };
+
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < group.busy.size();) {
+                const auto [stream, oneshot] = group.busy[i];
+                if (!oneshot || !drained(*stream)) {
+                    ++ i;
+                    continue;
+                }
+                recycle(*stream);
+                group.busy[i] = group.busy.back();
+                group.busy.pop_back();
+                group.idle.push_back(stream);
+                ++ n;
+            }
+            counters.reclaimed += n;
+            return n;
+        }
+
+        static void recycle(AudioStream& stream) noexcept {
+            SDL_ClearAudioStream(stream.handle);
+            SDL_SetAudioStreamGain(stream.handle, 1.0f);
+            SDL_SetAudioStreamFrequencyRatio(stream.handle, 1.0f);
+            // the slots are dropped too, so no callback of the previous user outlives its lease
+            SDL_SetAudioStreamGetCallback(stream.handle, nullptr, nullptr);
+            SDL_SetAudioStreamPutCallback(stream.handle, nullptr, nullptr);
+            stream.get_slot.reset();
+            stream.put_slot.reset();
+        }
+    };
+}
+
+#endif //SDL_AUDIO_POOL_HPP
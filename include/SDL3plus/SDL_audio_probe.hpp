@@ -0,0 +1,261 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_PROBE_HPP
+#define SDL_AUDIO_PROBE_HPP
+#include <SDL3/SDL_timer.h>
+#include "SDL_audio.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <span>
+
+namespace SDL {
+    /**
+     * lock-free log-linear histogram: every power of two is split into 8 linear sub-buckets,
+     * so a percentile is off by at most 1/8 of its value. values below 8 are exact.
+     * one writer (the audio thread) and any number of readers, everything is relaxed,
+     * a reader may see a record half way (count ahead of the bucket) and that is fine for statistics.
+     */
+    struct Histogram {
+        static constexpr int sub_bits = 3;
+        static constexpr Uint64 sub_buckets = 1 << sub_bits;
+        static constexpr std::size_t buckets = (64 - sub_bits + 1) * sub_buckets;
+
+        std::array<std::atomic<Uint64>, buckets>
+            counts{};
+        std::atomic<Uint64>
+            total{0};
+
+        static constexpr std::size_t index(const Uint64 v) noexcept {
+            if (v < sub_buckets)
+                return static_cast<std::size_t>(v);
+            const auto width = std::bit_width(v);
+            const auto sub = (v >> (width - sub_bits - 1)) & (sub_buckets - 1);
+            return static_cast<std::size_t>((width - sub_bits) * sub_buckets + sub);
+        }
+
+        // [lower(i), lower(i) + span(i)) is the range of bucket i
+        static constexpr Uint64 lower(const std::size_t i) noexcept {
+            if (i < sub_buckets)
+                return i;
+            const auto width = static_cast<int>(i / sub_buckets) + sub_bits;
+            return (sub_buckets + i % sub_buckets) << (width - sub_bits - 1);
+        }
+
+        static constexpr Uint64 span(const std::size_t i) noexcept {
+            if (i < sub_buckets)
+                return 1;
+            return Uint64{1} << (static_cast<int>(i / sub_buckets) - 1);
+        }
+
+        void record(const Uint64 v) noexcept {
+            counts[index(v)].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Uint64 count() const noexcept {
+            return total.load(std::memory_order_relaxed);
+        }
+
+        // q in [0, 1], linear inside the bucket the rank falls into
+        double percentile(const double q) const noexcept {
+            auto snapshot = std::array<Uint64, buckets>{};
+            Uint64 n = 0;
+            for (std::size_t b = 0; b < buckets; ++ b)
+                n += snapshot[b] = counts[b].load(std::memory_order_relaxed);
+            if (n == 0)
+                return 0.0;
+
+            const auto rank = q * static_cast<double>(n);
+            double seen = 0.0;
+            for (std::size_t b = 0; b < buckets; ++ b) {
+                if (snapshot[b] == 0)
+                    continue;
+                if (seen + static_cast<double>(snapshot[b]) >= rank)
+                    return static_cast<double>(lower(b)) + static_cast<double>(span(b)) * (rank - seen) / static_cast<double>(snapshot[b]);
+                seen += static_cast<double>(snapshot[b]);
+            }
+            return static_cast<double>(lower(buckets - 1));
+        }
+
+        void reset() noexcept {
+            for (auto& c: counts)
+                c.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * opt-in health counters for a stream or a device.
+     *
+     * stream side: bind wrap(callback) as the get callback instead of callback,
+     * or attach(stream) when the stream is fed from another thread with put().
+     * every call records the interval since the previous one, its jitter
+     * (difference between consecutive intervals), the queue depth SDL found,
+     * bytes requested vs supplied and how long the producer took.
+     *   underrun:   the callback queued less than additional_amount
+     *   starvation: the stream was already empty when the device asked
+     *
+     * device side: the probe is a postmix callable, device.setAudioPostmixCallback(probe),
+     * or BusGraph::add_effect(master_bus, std::ref(probe)) when a graph owns the postmix slot.
+     *
+     * all counters are relaxed atomics written by the audio thread only,
+     * report() can be called from any thread at any time.
+     */
+    struct AudioProbe {
+        struct Report {
+            Uint64
+                callbacks;
+            Uint64
+                underruns;
+            Uint64
+                starvations;
+            Uint64
+                requested;
+            Uint64
+                supplied;
+            double
+                interval_p50_us;
+            double
+                interval_p99_us;
+            double
+                jitter_p50_us;
+            double
+                jitter_p99_us;
+            double
+                duration_p99_us;
+            double
+                depth_p50;
+            double
+                depth_p99;
+        };
+
+        Histogram
+            interval_ns;
+        Histogram
+            jitter_ns;
+        Histogram
+            duration_ns;
+        Histogram
+            depth_bytes;
+        std::atomic<Uint64>
+            callbacks{0};
+        std::atomic<Uint64>
+            underruns{0};
+        std::atomic<Uint64>
+            starvations{0};
+        std::atomic<Uint64>
+            requested{0};
+        std::atomic<Uint64>
+            supplied{0};
+
+        // audio thread only
+        Uint64
+            last_tick{0};
+        Uint64
+            last_interval{0};
+
+        AudioProbe()=default;
+        AudioProbe(const AudioProbe&)=delete;
+        AudioProbe& operator = (const AudioProbe&)=delete;
+
+        template<typename F>
+        struct Probed {
+            AudioProbe*
+                probe;
+            F
+                callback;
+
+            void operator () (AudioStream& stream, const int additional_amount, const int total_amount) {
+                const auto before = SDL_GetAudioStreamQueued(stream.handle);
+                const auto begin = probe -> tick();
+                callback(stream, additional_amount, total_amount);
+                const auto end = SDL_GetTicksNS();
+                const auto after = SDL_GetAudioStreamQueued(stream.handle);
+                probe -> stream_block(before, after, additional_amount, end - begin);
+            }
+        };
+
+        // the returned callable must be bound with add_callback_get, the probe must outlive the binding
+        template<typename F>
+        requires std::invocable<std::decay_t<F>&, AudioStream&, int, int>
+        Probed<std::decay_t<F>> wrap(F&& callback) noexcept {
+            return {this, std::forward<F>(callback)};
+        }
+
+        // measure only, for streams fed with put() from elsewhere
+        void attach(AudioStream& stream) {
+            stream.add_callback_get(wrap([](AudioStream&, int, int) noexcept {}));
+        }
+
+        // device postmix callback, one call per device block
+        void operator () (const AudioSpec&, std::span<float>) noexcept {
+            tick();
+            callbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Uint64 tick() noexcept {
+            const auto now = SDL_GetTicksNS();
+            if (last_tick != 0) {
+                const auto interval = now - last_tick;
+                interval_ns.record(interval);
+                if (last_interval != 0)
+                    jitter_ns.record(interval > last_interval ? interval - last_interval : last_interval - interval);
+                last_interval = interval;
+            }
+            last_tick = now;
+            return now;
+        }
+
+        void stream_block(const int before, const int after, const int additional_amount, const Uint64 duration) noexcept {
+            callbacks.fetch_add(1, std::memory_order_relaxed);
+            duration_ns.record(duration);
+            if (before >= 0)
+                depth_bytes.record(static_cast<Uint64>(before));
+            if (additional_amount <= 0)
+                return;
+
+            const auto got = before >= 0 && after > before ? after - before : 0;
+            requested.fetch_add(static_cast<Uint64>(additional_amount), std::memory_order_relaxed);
+            supplied.fetch_add(static_cast<Uint64>(got), std::memory_order_relaxed);
+            if (got < additional_amount)
+                underruns.fetch_add(1, std::memory_order_relaxed);
+            if (before == 0)
+                starvations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Report report() const noexcept {
+            return {
+                callbacks.load(std::memory_order_relaxed),
+                underruns.load(std::memory_order_relaxed),
+                starvations.load(std::memory_order_relaxed),
+                requested.load(std::memory_order_relaxed),
+                supplied.load(std::memory_order_relaxed),
+                interval_ns.percentile(0.50) / 1000.0,
+                interval_ns.percentile(0.99) / 1000.0,
+                jitter_ns.percentile(0.50) / 1000.0,
+                jitter_ns.percentile(0.99) / 1000.0,
+                duration_ns.percentile(0.99) / 1000.0,
+                depth_bytes.percentile(0.50),
+                depth_bytes.percentile(0.99),
+            };
+        }
+
+        // counters only, safe from any thread; the next interval is measured from the last callback
+        void reset() noexcept {
+            interval_ns.reset();
+            jitter_ns.reset();
+            duration_ns.reset();
+            depth_bytes.reset();
+            callbacks.store(0, std::memory_order_relaxed);
+            underruns.store(0, std::memory_order_relaxed);
+            starvations.store(0, std::memory_order_relaxed);
+            requested.store(0, std::memory_order_relaxed);
+            supplied.store(0, std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif //SDL_AUDIO_PROBE_HPP
@@ -0,0 +1,271 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_RESAMPLE_HPP
+#define SDL_AUDIO_RESAMPLE_HPP
+#include "SDL_audio.hpp"
+#include "SDL_intrin.hpp"
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace SDL {
+    enum class ResampleQuality {
+        FAST,       // 8 taps,  64 phases
+        MEDIUM,     // 16 taps, 128 phases
+        BEST,       // 32 taps, 256 phases
+    };
+
+    namespace resample {
+        struct Design {
+            int
+                taps;
+            int
+                phases;
+            double
+                beta;       // kaiser window
+            double
+                passband;   // fraction of the nyquist frequency kept
+        };
+
+        constexpr Design design(const ResampleQuality quality) noexcept {
+            switch (quality) {
+            case ResampleQuality::FAST:
+                return {8, 64, 5.0, 0.85};
+            case ResampleQuality::MEDIUM:
+                return {16, 128, 7.0, 0.91};
+            case ResampleQuality::BEST:
+            default:
+                return {32, 256, 9.5, 0.95};
+            }
+        }
+
+        // zeroth order modified bessel function of the first kind, series expansion
+        inline double bessel_i0(const double x) noexcept {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; ++ k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+                if (term < sum * 1e-17)
+                    break;
+            }
+            return sum;
+        }
+
+        // taps is a multiple of 4 for every design
+        inline float dot(const float* a, const float* b, const int taps) noexcept {
+            int i = 0;
+#if defined(SDL3PLUS_SSE2)
+            auto acc = _mm_setzero_ps();
+            for (; i < taps; i += 4)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+            acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+            return _mm_cvtss_f32(acc);
+#elif defined(SDL3PLUS_NEON)
+            auto acc = vdupq_n_f32(0.0f);
+            for (; i < taps; i += 4)
+                acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+            return vaddvq_f32(acc);
+#else
+            float acc[4]{};
+            for (; i < taps; i += 4)
+                for (int k = 0; k < 4; ++ k)
+                    acc[k] += a[i + k] * b[i + k];
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+        }
+
+        // dst = lo + (hi - lo) * t
+        inline void lerp(float* dst, const float* lo, const float* hi, const float t, const int taps) noexcept {
+            int i = 0;
+#if defined(SDL3PLUS_SSE2)
+            const auto vt = _mm_set1_ps(t);
+            for (; i < taps; i += 4) {
+                const auto l = _mm_loadu_ps(lo + i);
+                _mm_storeu_ps(dst + i, _mm_add_ps(l, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(hi + i), l), vt)));
+            }
+#elif defined(SDL3PLUS_NEON)
+            const auto vt = vdupq_n_f32(t);
+            for (; i < taps; i += 4) {
+                const auto l = vld1q_f32(lo + i);
+                vst1q_f32(dst + i, vmlaq_f32(l, vsubq_f32(vld1q_f32(hi + i), l), vt));
+            }
+#endif
+            for (; i < taps; ++ i)
+                dst[i] = lo[i] + (hi[i] - lo[i]) * t;
+        }
+    }
+
+    /**
+     * polyphase windowed-sinc resampler for interleaved F32.
+     *
+     * the kaiser windowed sinc is tabulated at construction (phases + 1 rows of taps),
+     * coefficients between two phases are linearly interpolated per output frame,
+     * channels are kept planar internally so every tap loop is a contiguous SIMD dot product.
+     * the cutoff follows the construction ratio (anti-aliasing when downsampling),
+     * frequency() may change the step every block for pitch shifting.
+     *
+     * as a pipeline stage: create the AudioStream with src spec {F32, channels, dst_rate}
+     * and feed it through put(stream, samples), SDL then only has to convert the format.
+     */
+    struct Resampler {
+        int
+            channels;
+        int
+            src_rate;
+        int
+            dst_rate;
+        resample::Design
+            design;
+        // (phases + 1) * taps
+        std::vector<float>
+            table;
+        // per channel input history, planar
+        std::vector<std::vector<float>>
+            history;
+        // read position in input frames, relative to history[c][0]
+        double
+            position;
+        // input frames per output frame
+        double
+            step;
+        std::vector<float>
+            coefficients;
+        std::vector<float>
+            staging;
+
+        Resampler(const int channels, const int src_rate, const int dst_rate, const ResampleQuality quality=ResampleQuality::MEDIUM):
+            channels{channels},
+            src_rate{src_rate},
+            dst_rate{dst_rate},
+            design{resample::design(quality)},
+            coefficients(static_cast<std::size_t>(design.taps)) {
+            if (channels <= 0 || src_rate <= 0 || dst_rate <= 0) {
+                SDL_SetError("invalid resampler parameters");
+                throw Error{};
+            }
+            history.resize(static_cast<std::size_t>(channels));
+            step = static_cast<double>(src_rate) / dst_rate;
+            build_table();
+            reset();
+        }
+
+        void build_table() {
+            const auto taps = design.taps;
+            const auto half = taps / 2;
+            // lower the cutoff when downsampling
+            const auto cutoff = design.passband * SDL::min(1.0, static_cast<double>(dst_rate) / src_rate);
+            const auto i0_beta = resample::bessel_i0(design.beta);
+
+            table.resize(static_cast<std::size_t>(design.phases + 1) * taps);
+            for (int p = 0; p <= design.phases; ++ p) {
+                const auto frac = static_cast<double>(p) / design.phases;
+                auto* row = table.data() + static_cast<std::size_t>(p) * taps;
+
+                double sum = 0.0;
+                for (int j = 0; j < taps; ++ j) {
+                    // distance of tap j from the output position
+                    const auto t = (j - half + 1) - frac;
+                    const auto x = std::numbers::pi * cutoff * t;
+                    const auto sinc = t == 0.0 ? 1.0 : std::sin(x) / x;
+                    const auto r = t / half;
+                    const auto window = r * r >= 1.0 ? 0.0 : resample::bessel_i0(design.beta * std::sqrt(1.0 - r * r)) / i0_beta;
+                    const auto c = cutoff * sinc * window;
+                    row[j] = static_cast<float>(c);
+                    sum += c;
+                }
+                // unity gain at DC
+                for (int j = 0; j < taps; ++ j)
+                    row[j] = static_cast<float>(row[j] / sum);
+            }
+        }
+
+        // drop the history, the next block starts from silence
+        void reset() {
+            const auto half = design.taps / 2;
+            for (auto& h: history)
+                h.assign(static_cast<std::size_t>(half - 1), 0.0f);
+            position = half - 1;
+        }
+
+        // same meaning and range as AudioStream::frequency: 2.0 plays twice as fast (one octave up), 0.01 to 100
+        void frequency(const float ratio) {
+            // negated so NaN is rejected too
+            if (!(ratio >= 0.01f && ratio <= 100.0f)) {
+                SDL_SetError("frequency ratio %g out of range [0.01, 100]", static_cast<double>(ratio));
+                throw Error{};
+            }
+            step = static_cast<double>(src_rate) / dst_rate * ratio;
+        }
+
+        float frequency() const noexcept {
+            return static_cast<float>(step * dst_rate / src_rate);
+        }
+
+        // output frames the next process() can produce for `frames` more input, rounded up
+        std::size_t output_frames(const std::size_t frames) const noexcept {
+            const auto half = design.taps / 2;
+            const auto available = static_cast<double>(history.front().size() + frames) - half;
+            return available <= position ? 0 : static_cast<std::size_t>(std::ceil((available - position) / step));
+        }
+
+        /**
+         * consume every frame of in (interleaved), write as many frames as out can hold.
+         * input the output could not make room for stays in the history.
+         * returns: frames written
+         */
+        std::size_t process(const std::span<const float> in, const std::span<float> out) {
+            const auto frames_in = in.size() / channels;
+            for (int c = 0; c < channels; ++ c) {
+                auto& h = history[c];
+                const auto beg = h.size();
+                h.resize(beg + frames_in);
+                for (std::size_t i = 0; i < frames_in; ++ i)
+                    h[beg + i] = in[i * channels + c];
+            }
+
+            const auto taps = design.taps;
+            const auto half = taps / 2;
+            const auto limit = static_cast<double>(history.front().size()) - half;
+            const auto frames_out = out.size() / channels;
+
+            std::size_t produced = 0;
+            while (produced < frames_out && position < limit) {
+                const auto base = static_cast<std::size_t>(position);
+                const auto phase = (position - base) * design.phases;
+                const auto p = static_cast<int>(phase);
+                const auto* row = table.data() + static_cast<std::size_t>(p) * taps;
+                resample::lerp(coefficients.data(), row, row + taps, static_cast<float>(phase - p), taps);
+
+                const auto first = base + 1 - half;
+                for (int c = 0; c < channels; ++ c)
+                    out[produced * channels + c] = resample::dot(history[c].data() + first, coefficients.data(), taps);
+
+                position += step;
+                ++ produced;
+            }
+
+            // keep only what the next output frame still needs
+            const auto needed = static_cast<std::size_t>(position) + 1 - half;
+            const auto drop = SDL::min(needed, history.front().size());
+            if (drop > 0) {
+                for (auto& h: history)
+                    h.erase(h.begin(), h.begin() + static_cast<std::ptrdiff_t>(drop));
+                position -= static_cast<double>(drop);
+            }
+            return produced;
+        }
+
+        // resample a block and queue it on the stream
+        void put(AudioStream& stream, const std::span<const float> in) {
+            staging.resize(output_frames(in.size() / channels) * channels);
+            const auto frames = process(in, staging);
+            stream.put({reinterpret_cast<const unsigned char*>(staging.data()), frames * channels * sizeof(float)});
+        }
+    };
+}
+
+#endif //SDL_AUDIO_RESAMPLE_HPP
@@ -0,0 +1,137 @@
+//
+// Created by FCWY on 26-10-17.
+//
+// ReSharper disable CppMemberFunctionMayBeConst
+#ifndef SDL_AUDIO_RING_HPP
+#define SDL_AUDIO_RING_HPP
+#include "SDL_audio.hpp"
+#include "SDL_cpuinfo.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <span>
+
+namespace SDL {
+    /**
+     * single producer / single consumer byte ring in front of an AudioStream.
+     *
+     * producer: any one thread, calls put(), never blocks and never takes the stream lock.
+     * consumer: the get-callback of the bound stream, which moves everything
+     *           queued so far into SDL_PutAudioStreamData in (at most) two calls.
+     *
+     * the bound AudioStream must outlive the ring,
+     * and its get-callback is owned by the ring while the ring is alive.
+     */
+    struct AudioRing {
+        AudioStream&
+            stream;
+        std::size_t
+            capacity;
+        unsigned char*
+            buffer;
+
+        // write index, owned by producer
+        alignas(cacheline_size) std::atomic_size_t
+            head{0};
+        // producer's snapshot of tail
+        std::size_t
+            tail_cache{0};
+
+        // read index, owned by consumer
+        alignas(cacheline_size) std::atomic_size_t
+            tail{0};
+        // SDL_PutAudioStreamData calls that failed, their bytes stay queued for the next drain
+        std::atomic<Uint64>
+            put_failures{0};
+
+        // capacity will be rounded up to a power of 2 and at least one cache line
+        AudioRing(AudioStream& stream, const std::size_t capacity):
+            stream{stream},
+            capacity{std::bit_ceil(SDL::max(capacity, cacheline_size))},
+            buffer{static_cast<unsigned char*>(aligned::alloc(cacheline_size, this->capacity))} {
+            if (!buffer)
+                throw Error{};
+            try {
+                stream.add_callback_get(on_get, this);
+            }
+            catch (Error&) {
+                aligned::free(buffer);
+                throw;
+            }
+        }
+
+        AudioRing(const AudioRing&)=delete;
+        AudioRing& operator = (const AudioRing&)=delete;
+
+        ~AudioRing() noexcept {
+            SDL_SetAudioStreamGetCallback(stream.handle, nullptr, nullptr);
+            aligned::free(buffer);
+        }
+
+        /**
+         * producer side.
+         * copies the whole block or nothing, so frames are never split
+         * returns: false if the ring does not have enough room
+         */
+        bool put(const std::span<const unsigned char> data) noexcept {
+            const auto h = head.load(std::memory_order_relaxed);
+            if (capacity - (h - tail_cache) < data.size()) {
+                tail_cache = tail.load(std::memory_order_acquire);
+                if (capacity - (h - tail_cache) < data.size())
+                    return false;
+            }
+
+            const auto offset = h & (capacity - 1);
+            const auto first = SDL::min(data.size(), capacity - offset);
+            std::copy_n(data.data(), first, buffer + offset);
+            std::copy_n(data.data() + first, data.size() - first, buffer);
+
+            head.store(h + data.size(), std::memory_order_release);
+            return true;
+        }
+
+        // producer side, bytes put() can take right now
+        std::size_t writable() const noexcept {
+            return capacity - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+        }
+
+        // bytes waiting to be drained into the stream
+        std::size_t readable() const noexcept {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * consumer side, called from the get-callback.
+         * may also be called by hand when the stream is not bound,
+         * as long as only one thread consumes
+         */
+        void drain() noexcept {
+            const auto t = tail.load(std::memory_order_relaxed);
+            const auto h = head.load(std::memory_order_acquire);
+            const auto size = h - t;
+            if (size == 0)
+                return;
+
+            // the tail only moves past what the stream accepted
+            const auto offset = t & (capacity - 1);
+            const auto first = SDL::min(size, capacity - offset);
+            if (!SDL_PutAudioStreamData(stream.handle, buffer + offset, static_cast<int>(first))) {
+                put_failures.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (first < size && !SDL_PutAudioStreamData(stream.handle, buffer, static_cast<int>(size - first))) {
+                put_failures.fetch_add(1, std::memory_order_relaxed);
+                tail.store(t + first, std::memory_order_release);
+                return;
+            }
+
+            tail.store(h, std::memory_order_release);
+        }
+
+        static void SDLCALL on_get(void* userdata, SDL_AudioStream*, int, int) noexcept {
+            static_cast<AudioRing*>(userdata) -> drain();
+        }
+    };
+}
+
+#endif //SDL_AUDIO_RING_HPP
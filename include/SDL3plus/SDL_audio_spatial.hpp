@@ -0,0 +1,424 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_SPATIAL_HPP
+#define SDL_AUDIO_SPATIAL_HPP
+#include "SDL_audio.hpp"
+#include "SDL_intrin.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace SDL {
+    enum class SpeakerLayout {
+        // L R
+        STEREO,
+        // SDL's 5.1 order: FL FR FC LFE BL BR
+        SURROUND_51
+    };
+
+    constexpr int speaker_count(const SpeakerLayout layout) noexcept {
+        return layout == SpeakerLayout::STEREO ? 2 : 6;
+    }
+
+    struct SpatialParams {
+        // full volume up to here
+        float
+            min_distance{1.0f};
+        // no further attenuation past here
+        float
+            max_distance{100.0f};
+        // inverse distance clamped: min / (min + rolloff * (d - min))
+        float
+            rolloff{1.0f};
+        // LFE send relative to the attenuated level, 5.1 only
+        float
+            lfe{0.0f};
+    };
+
+    namespace spatial {
+        /**
+         * 4 voices at a time, the kernel below is written once against this
+         * and compiles to SSE2, NEON or plain loops
+         */
+#if defined(SDL3PLUS_SSE2)
+        struct Mask {
+            __m128
+                m;
+            Mask operator & (const Mask o) const noexcept { return {_mm_and_ps(m, o.m)}; }
+        };
+        struct Vec4 {
+            __m128
+                v;
+            static Vec4 splat(const float x) noexcept { return {_mm_set1_ps(x)}; }
+            static Vec4 load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+            void store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+            Vec4 operator + (const Vec4 o) const noexcept { return {_mm_add_ps(v, o.v)}; }
+            Vec4 operator - (const Vec4 o) const noexcept { return {_mm_sub_ps(v, o.v)}; }
+            Vec4 operator * (const Vec4 o) const noexcept { return {_mm_mul_ps(v, o.v)}; }
+            Vec4 operator / (const Vec4 o) const noexcept { return {_mm_div_ps(v, o.v)}; }
+            Mask operator > (const Vec4 o) const noexcept { return {_mm_cmpgt_ps(v, o.v)}; }
+            Mask operator >= (const Vec4 o) const noexcept { return {_mm_cmpge_ps(v, o.v)}; }
+        };
+        inline Vec4 sqrt(const Vec4 a) noexcept { return {_mm_sqrt_ps(a.v)}; }
+        inline Vec4 min(const Vec4 a, const Vec4 b) noexcept { return {_mm_min_ps(a.v, b.v)}; }
+        inline Vec4 max(const Vec4 a, const Vec4 b) noexcept { return {_mm_max_ps(a.v, b.v)}; }
+        // a where the mask is set, 0 elsewhere
+        inline Vec4 keep(const Mask m, const Vec4 a) noexcept { return {_mm_and_ps(m.m, a.v)}; }
+#elif defined(SDL3PLUS_NEON)
+        struct Mask {
+            uint32x4_t
+                m;
+            Mask operator & (const Mask o) const noexcept { return {vandq_u32(m, o.m)}; }
+        };
+        struct Vec4 {
+            float32x4_t
+                v;
+            static Vec4 splat(const float x) noexcept { return {vdupq_n_f32(x)}; }
+            static Vec4 load(const float* p) noexcept { return {vld1q_f32(p)}; }
+            void store(float* p) const noexcept { vst1q_f32(p, v); }
+            Vec4 operator + (const Vec4 o) const noexcept { return {vaddq_f32(v, o.v)}; }
+            Vec4 operator - (const Vec4 o) const noexcept { return {vsubq_f32(v, o.v)}; }
+            Vec4 operator * (const Vec4 o) const noexcept { return {vmulq_f32(v, o.v)}; }
+            Vec4 operator / (const Vec4 o) const noexcept { return {vdivq_f32(v, o.v)}; }
+            Mask operator > (const Vec4 o) const noexcept { return {vcgtq_f32(v, o.v)}; }
+            Mask operator >= (const Vec4 o) const noexcept { return {vcgeq_f32(v, o.v)}; }
+        };
+        inline Vec4 sqrt(const Vec4 a) noexcept { return {vsqrtq_f32(a.v)}; }
+        inline Vec4 min(const Vec4 a, const Vec4 b) noexcept { return {vminq_f32(a.v, b.v)}; }
+        inline Vec4 max(const Vec4 a, const Vec4 b) noexcept { return {vmaxq_f32(a.v, b.v)}; }
+        inline Vec4 keep(const Mask m, const Vec4 a) noexcept { return {vreinterpretq_f32_u32(vandq_u32(m.m, vreinterpretq_u32_f32(a.v)))}; }
+#else
+        struct Mask {
+            bool
+                m[4];
+            Mask operator & (const Mask o) const noexcept { return {{m[0] && o.m[0], m[1] && o.m[1], m[2] && o.m[2], m[3] && o.m[3]}}; }
+        };
+        struct Vec4 {
+            float
+                v[4];
+            template<typename F>
+            static Vec4 each(F&& f) noexcept { return {{f(0), f(1), f(2), f(3)}}; }
+            static Vec4 splat(const float x) noexcept { return {{x, x, x, x}}; }
+            static Vec4 load(const float* p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+            void store(float* p) const noexcept { std::copy_n(v, 4, p); }
+            Vec4 operator + (const Vec4 o) const noexcept { return each([&](int i) { return v[i] + o.v[i]; }); }
+            Vec4 operator - (const Vec4 o) const noexcept { return each([&](int i) { return v[i] - o.v[i]; }); }
+            Vec4 operator * (const Vec4 o) const noexcept { return each([&](int i) { return v[i] * o.v[i]; }); }
+            Vec4 operator / (const Vec4 o) const noexcept { return each([&](int i) { return v[i] / o.v[i]; }); }
+            Mask operator > (const Vec4 o) const noexcept { return {{v[0] > o.v[0], v[1] > o.v[1], v[2] > o.v[2], v[3] > o.v[3]}}; }
+            Mask operator >= (const Vec4 o) const noexcept { return {{v[0] >= o.v[0], v[1] >= o.v[1], v[2] >= o.v[2], v[3] >= o.v[3]}}; }
+        };
+        inline Vec4 sqrt(const Vec4 a) noexcept { return Vec4::each([&](int i) { return std::sqrt(a.v[i]); }); }
+        inline Vec4 min(const Vec4 a, const Vec4 b) noexcept { return Vec4::each([&](int i) { return std::min(a.v[i], b.v[i]); }); }
+        inline Vec4 max(const Vec4 a, const Vec4 b) noexcept { return Vec4::each([&](int i) { return std::max(a.v[i], b.v[i]); }); }
+        inline Vec4 keep(const Mask m, const Vec4 a) noexcept { return Vec4::each([&](int i) { return m.m[i] ? a.v[i] : 0.0f; }); }
+#endif
+
+        // the 5 horizontal speakers of 5.1 in ring order, azimuth in degrees, + is right
+        struct Speaker {
+            int
+                channel;
+            float
+                azimuth;
+        };
+        constexpr std::array<Speaker, 5> ring_51{{
+            {0, -30.0f}, {2, 0.0f}, {1, 30.0f}, {5, 110.0f}, {4, -110.0f}
+        }};
+
+        /**
+         * 2D VBAP: a direction between two neighbouring speakers s1, s2 is g1 * s1 + g2 * s2,
+         * solved with the inverse of [s1 s2]. only the pair the direction falls in
+         * has both gains >= 0, so every pair is evaluated and the others are masked out.
+         */
+        struct Pair {
+            int
+                first;
+            int
+                second;
+            // inverse of the 2x2 matrix with the speaker directions (x = sin, z = cos) as columns
+            float
+                m00, m01, m10, m11;
+        };
+
+        inline std::array<Pair, 5> pairs_51() noexcept {
+            std::array<Pair, 5> ret{};
+            for (std::size_t i = 0; i < ring_51.size(); ++ i) {
+                const auto& a = ring_51[i];
+                const auto& b = ring_51[(i + 1) % ring_51.size()];
+                const auto ax = std::sin(a.azimuth * std::numbers::pi_v<float> / 180), az = std::cos(a.azimuth * std::numbers::pi_v<float> / 180);
+                const auto bx = std::sin(b.azimuth * std::numbers::pi_v<float> / 180), bz = std::cos(b.azimuth * std::numbers::pi_v<float> / 180);
+                const auto det = ax * bz - bx * az;
+                ret[i] = {a.channel, b.channel, bz / det, -bx / det, -az / det, ax / det};
+            }
+            return ret;
+        }
+
+        /**
+         * gains for voices [0, count), count a multiple of 4.
+         * gains[c * stride + v] is channel c of voice v
+         */
+        inline void compute(const SpeakerLayout layout, const SpatialParams& params,
+            const float* xs, const float* ys, const float* zs, const float* volumes,
+            float* gains, const std::size_t stride, const std::size_t count) noexcept {
+            static const auto pairs = pairs_51();
+
+            const auto zero = Vec4::splat(0.0f), one = Vec4::splat(1.0f), half = Vec4::splat(0.5f), tiny = Vec4::splat(1e-6f);
+            const auto closest = SDL::max(params.min_distance, 1e-3f);
+            const auto min_d = Vec4::splat(closest);
+            // never below min_d, or the clamped distance drives the denominator to 0
+            const auto max_d = Vec4::splat(SDL::max(params.max_distance, closest));
+            const auto rolloff = Vec4::splat(params.rolloff);
+            const auto lfe = Vec4::splat(params.lfe);
+
+            for (std::size_t v = 0; v < count; v += 4) {
+                const auto x = Vec4::load(xs + v), y = Vec4::load(ys + v), z = Vec4::load(zs + v);
+                const auto h2 = x * x + z * z;
+                const auto d = sqrt(h2 + y * y);
+                const auto attenuation = Vec4::load(volumes + v) * min_d / (min_d + rolloff * (min(max(d, min_d), max_d) - min_d));
+                // 0 for a voice sitting on the listener, it gets no direction
+                const auto inv_d = keep(d > tiny, one / max(d, tiny));
+
+                if (layout == SpeakerLayout::STEREO) {
+                    // equal power on the left / right component of the direction
+                    const auto pan = x * inv_d;
+                    (sqrt(max((one - pan) * half, zero)) * attenuation).store(gains + v);
+                    (sqrt(max((one + pan) * half, zero)) * attenuation).store(gains + stride + v);
+                    continue;
+                }
+
+                const auto h = sqrt(h2);
+                const auto inv_h = keep(h > tiny, one / max(h, tiny));
+                const auto ux = x * inv_h, uz = z * inv_h;
+
+                Vec4 g[6] = {zero, zero, zero, zero, zero, zero};
+                for (const auto& p: pairs) {
+                    const auto g1 = Vec4::splat(p.m00) * ux + Vec4::splat(p.m01) * uz;
+                    const auto g2 = Vec4::splat(p.m10) * ux + Vec4::splat(p.m11) * uz;
+                    // >= on one side only, a direction on a speaker counts once
+                    const auto inside = (g1 >= zero) & (g2 > zero);
+                    g[p.first] = g[p.first] + keep(inside, g1);
+                    g[p.second] = g[p.second] + keep(inside, g2);
+                }
+
+                // the more a voice is above / below, the more it spreads evenly over the ring (1 / sqrt 5 each)
+                const auto focus = h * inv_d;
+                const auto spread = (one - focus) * Vec4::splat(0.4472136f);
+                auto power = zero;
+                for (const auto& s: ring_51) {
+                    g[s.channel] = g[s.channel] * focus + spread;
+                    power = power + g[s.channel] * g[s.channel];
+                }
+                const auto normalize = attenuation / sqrt(max(power, tiny));
+                for (const auto& s: ring_51)
+                    (g[s.channel] * normalize).store(gains + static_cast<std::size_t>(s.channel) * stride + v);
+                (lfe * attenuation).store(gains + 3 * stride + v);
+            }
+        }
+
+        /**
+         * out (interleaved, Channels) += src * gain, the gain of each channel moving linearly
+         * from `from` to `to` over the block
+         */
+        template<int Channels>
+        void mix(const float* src, float* out, const std::size_t frames, const float* from, const float* to) noexcept {
+            const auto scale = 1.0f / static_cast<float>(frames);
+            float g[Channels], step[Channels];
+            for (int c = 0; c < Channels; ++ c) {
+                g[c] = from[c];
+                step[c] = (to[c] - from[c]) * scale;
+            }
+
+            std::size_t i = 0;
+#if defined(SDL3PLUS_SSE2)
+            if constexpr (Channels == 2) {
+                // two frames per vector: {L0 R0 L1 R1}
+                auto gain = _mm_setr_ps(g[0], g[1], g[0] + step[0], g[1] + step[1]);
+                const auto advance = _mm_setr_ps(2 * step[0], 2 * step[1], 2 * step[0], 2 * step[1]);
+                for (; i + 2 <= frames; i += 2) {
+                    const auto s = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(src + i)));
+                    const auto pair = _mm_unpacklo_ps(s, s);
+                    _mm_storeu_ps(out + 2 * i, _mm_add_ps(_mm_loadu_ps(out + 2 * i), _mm_mul_ps(pair, gain)));
+                    gain = _mm_add_ps(gain, advance);
+                }
+                g[0] = _mm_cvtss_f32(gain);
+                g[1] = _mm_cvtss_f32(_mm_shuffle_ps(gain, gain, _MM_SHUFFLE(1, 1, 1, 1)));
+            }
+            else if constexpr (Channels == 6) {
+                // FL FR FC LFE in one vector, BL BR in the low half of another
+                auto front = _mm_loadu_ps(g);
+                auto back = _mm_setr_ps(g[4], g[5], 0.0f, 0.0f);
+                const auto front_step = _mm_loadu_ps(step);
+                const auto back_step = _mm_setr_ps(step[4], step[5], 0.0f, 0.0f);
+                for (; i < frames; ++ i) {
+                    const auto s = _mm_set1_ps(src[i]);
+                    auto* frame = out + 6 * i;
+                    _mm_storeu_ps(frame, _mm_add_ps(_mm_loadu_ps(frame), _mm_mul_ps(s, front)));
+                    const auto rest = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(frame + 4)));
+                    _mm_store_sd(reinterpret_cast<double*>(frame + 4), _mm_castps_pd(_mm_add_ps(rest, _mm_mul_ps(s, back))));
+                    front = _mm_add_ps(front, front_step);
+                    back = _mm_add_ps(back, back_step);
+                }
+            }
+#elif defined(SDL3PLUS_NEON)
+            if constexpr (Channels == 2) {
+                const float start[4] = {g[0], g[1], g[0] + step[0], g[1] + step[1]};
+                const float twice[4] = {2 * step[0], 2 * step[1], 2 * step[0], 2 * step[1]};
+                auto gain = vld1q_f32(start);
+                const auto advance = vld1q_f32(twice);
+                for (; i + 2 <= frames; i += 2) {
+                    const auto s = vld1_f32(src + i);
+                    const auto pair = vzip1q_f32(vcombine_f32(s, s), vcombine_f32(s, s));
+                    vst1q_f32(out + 2 * i, vmlaq_f32(vld1q_f32(out + 2 * i), pair, gain));
+                    gain = vaddq_f32(gain, advance);
+                }
+                g[0] = vgetq_lane_f32(gain, 0);
+                g[1] = vgetq_lane_f32(gain, 1);
+            }
+            else if constexpr (Channels == 6) {
+                auto front = vld1q_f32(g);
+                auto back = vld1_f32(g + 4);
+                const auto front_step = vld1q_f32(step);
+                const auto back_step = vld1_f32(step + 4);
+                for (; i < frames; ++ i) {
+                    auto* frame = out + 6 * i;
+                    vst1q_f32(frame, vmlaq_n_f32(vld1q_f32(frame), front, src[i]));
+                    vst1_f32(frame + 4, vmla_n_f32(vld1_f32(frame + 4), back, src[i]));
+                    front = vaddq_f32(front, front_step);
+                    back = vadd_f32(back, back_step);
+                }
+            }
+#endif
+            for (; i < frames; ++ i)
+                for (int c = 0; c < Channels; ++ c) {
+                    out[i * Channels + c] += src[i] * g[c];
+                    g[c] += step[c];
+                }
+        }
+    }
+
+    /**
+     * pan and distance gains for many mono voices at once.
+     *
+     * positions are listener relative, +x right, +y up, +z forward, stored as
+     * structure of arrays so update() computes 4 voices per instruction:
+     * clamped inverse distance attenuation, then equal power panning (stereo)
+     * or pairwise VBAP over the 5 horizontal speakers (5.1), with elevated voices spread over the ring.
+     * mix() adds every voice into an interleaved F32 block, each channel gain
+     * ramping from the previous update() to the current one across the block, so no zipper noise.
+     *
+     * call update() once per block, then mix(). not thread safe.
+     */
+    struct Spatializer {
+        SpeakerLayout
+            layout;
+        int
+            channels;
+        SpatialParams
+            params;
+        std::size_t
+            voices{0};
+        // voices rounded up to 4, the padding lanes sit at the origin with volume 0
+        std::size_t
+            stride{0};
+        std::vector<float>
+            x;
+        std::vector<float>
+            y;
+        std::vector<float>
+            z;
+        std::vector<float>
+            volume;
+        // [channel * stride + voice], this block's targets and the previous block's
+        std::vector<float>
+            gains;
+        std::vector<float>
+            previous;
+        bool
+            primed{false};
+
+        explicit Spatializer(const SpeakerLayout layout, const std::size_t voices=0, const SpatialParams& params={}):
+            layout{layout},
+            channels{speaker_count(layout)},
+            params{params} {
+            resize(voices);
+        }
+
+        // new voices start at the origin with volume 1, existing ones keep their state
+        void resize(const std::size_t count) {
+            const auto new_stride = (count + 3) / 4 * 4;
+            const auto grow = [&](std::vector<float>& v, const float fill) {
+                v.resize(new_stride, 0.0f);
+                std::fill(v.begin() + static_cast<std::ptrdiff_t>(SDL::min(voices, count)), v.end(), 0.0f);
+                std::fill_n(v.begin() + static_cast<std::ptrdiff_t>(SDL::min(voices, count)), count - SDL::min(voices, count), fill);
+            };
+            grow(x, 0.0f);
+            grow(y, 0.0f);
+            grow(z, 0.0f);
+            grow(volume, 1.0f);
+
+            auto regain = [&](std::vector<float>& v) {
+                auto next = std::vector<float>(new_stride * channels, 0.0f);
+                for (int c = 0; c < channels; ++ c)
+                    std::copy_n(v.begin() + static_cast<std::ptrdiff_t>(c * stride), SDL::min(voices, count), next.begin() + static_cast<std::ptrdiff_t>(c * new_stride));
+                v = std::move(next);
+            };
+            regain(gains);
+            regain(previous);
+
+            voices = count;
+            stride = new_stride;
+        }
+
+        void position(const std::size_t voice, const float px, const float py, const float pz) noexcept {
+            x[voice] = px;
+            y[voice] = py;
+            z[voice] = pz;
+        }
+
+        float gain(const std::size_t voice, const int channel) const noexcept {
+            return gains[static_cast<std::size_t>(channel) * stride + voice];
+        }
+
+        // targets of this block from the current positions, the last ones become the ramp start
+        void update() noexcept {
+            gains.swap(previous);
+            spatial::compute(layout, params, x.data(), y.data(), z.data(), volume.data(), gains.data(), stride, stride);
+            if (!primed) {
+                previous = gains;
+                primed = true;
+            }
+        }
+
+        /**
+         * out += every voice, sources[v] holds out.size() / channels mono samples of voice v,
+         * a null source is skipped (its ramp still advances with the next update)
+         */
+        void mix(const std::span<const float* const> sources, const std::span<float> out) const noexcept {
+            const auto frames = out.size() / static_cast<std::size_t>(channels);
+            if (frames == 0)
+                return;
+
+            float from[6], to[6];
+            const auto n = SDL::min(sources.size(), voices);
+            for (std::size_t v = 0; v < n; ++ v) {
+                if (!sources[v])
+                    continue;
+                for (int c = 0; c < channels; ++ c) {
+                    from[c] = previous[static_cast<std::size_t>(c) * stride + v];
+                    to[c] = gains[static_cast<std::size_t>(c) * stride + v];
+                }
+                if (layout == SpeakerLayout::STEREO)
+                    spatial::mix<2>(sources[v], out.data(), frames, from, to);
+                else
+                    spatial::mix<6>(sources[v], out.data(), frames, from, to);
+            }
+        }
+    };
+}
+
+#endif //SDL_AUDIO_SPATIAL_HPP
@@ -0,0 +1,377 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_VOICE_HPP
+#define SDL_AUDIO_VOICE_HPP
+#include <SDL3/SDL_timer.h>
+#include "SDL_audio.hpp"
+#include "SDL_audio_cache.hpp"
+#include "SDL_audio_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace SDL {
+    // slot in the low half, generation in the high half, a stale id never reaches a reused slot
+    enum class VoiceID: Uint64 {};
+    constexpr auto no_voice = VoiceID{0};
+
+    struct VoiceParams {
+        // compared first, audibility only breaks ties between equal priorities
+        int
+            priority{0};
+        float
+            volume{1.0f};
+        // inverse distance rolloff, full volume up to 1
+        float
+            distance{0.0f};
+        // fixed at play(), set() keeps the voice's original value
+        bool
+            loop{false};
+    };
+
+    /**
+     * logical voices on top of a stream pool, at most `voices` of them are ever real streams.
+     *
+     * every update() ranks the voices by (priority, volume / max(1, distance)),
+     * the top N audible ones own a pooled stream and are fed `lead` frames ahead,
+     * all the others are virtual: only their cursor advances with the clock, nothing is mixed.
+     * a voice coming in starts with a short fade in from its virtual cursor,
+     * a voice going out has its queue cut at the play position (under the stream lock)
+     * and replaced by a short fade out, the stream goes back to the pool once that drained.
+     * real voices keep a small advantage in the ranking so two close voices do not swap every frame.
+     *
+     * clips must be F32 (load them from PcmCache in an F32 spec), the fades are written into the samples.
+     * a fading stream is still leased, reserve about twice the voice budget in the pool.
+     * not thread safe, drive it from one thread.
+     */
+    struct VoiceManager {
+        using Clip = std::shared_ptr<const PcmClip>;
+
+        struct Voice {
+            Clip
+                clip;
+            VoiceParams
+                params;
+            // starts at 1 so no_voice never matches
+            Uint32
+                generation{1};
+            bool
+                active{false};
+            // frames, not wrapped for looping voices
+            double
+                cursor{0.0};
+            // real voices only: the stream and the next frame to queue on it
+            AudioStream*
+                stream{nullptr};
+            Uint64
+                feed{0};
+            bool
+                ending{false};
+        };
+
+        struct Stats {
+            std::size_t
+                real;
+            std::size_t
+                virtualized;
+            std::size_t
+                fading;
+        };
+
+        AudioStreamPool&
+            pool;
+        std::size_t
+            budget;
+        // frames kept queued ahead on every real voice
+        std::size_t
+            lead;
+        std::size_t
+            fade_frames;
+        float
+            hysteresis{1.25f};
+        // below this a voice is never made real
+        float
+            audible{1e-4f};
+        std::vector<Voice>
+            voices;
+        std::vector<Uint32>
+            free_slots;
+        // fade outs still playing, released to the pool once drained
+        std::vector<AudioStream*>
+            fading;
+        std::vector<Uint32>
+            ranking;
+        std::vector<float>
+            staging;
+        Uint64
+            last_tick{0};
+
+        VoiceManager(AudioStreamPool& pool, const std::size_t voices, const std::size_t lead=4096, const std::size_t fade_frames=256):
+            pool{pool},
+            budget{voices},
+            lead{lead},
+            fade_frames{fade_frames} {}
+
+        VoiceManager(const VoiceManager&)=delete;
+        VoiceManager& operator = (const VoiceManager&)=delete;
+
+        ~VoiceManager() noexcept {
+            for (auto& voice: voices)
+                if (voice.stream)
+                    pool.release(*voice.stream);
+            for (const auto stream: fading)
+                pool.release(*stream);
+        }
+
+        // starts virtual, the next update() decides whether it is heard
+        VoiceID play(Clip clip, const VoiceParams& params={}) {
+            if (!clip || clip -> spec.format != AudioFormat::F32) {
+                SDL_SetError("voices play F32 clips only");
+                throw Error{};
+            }
+
+            Uint32 slot;
+            if (!free_slots.empty()) {
+                slot = free_slots.back();
+                free_slots.pop_back();
+            }
+            else {
+                slot = static_cast<Uint32>(voices.size());
+                voices.emplace_back();
+            }
+
+            auto& voice = voices[slot];
+            voice.clip = std::move(clip);
+            voice.params = params;
+            voice.active = true;
+            voice.cursor = 0.0;
+            voice.stream = nullptr;
+            voice.feed = 0;
+            voice.ending = false;
+            return static_cast<VoiceID>(static_cast<Uint64>(voice.generation) << 32 | slot);
+        }
+
+        Voice* find(const VoiceID id) noexcept {
+            const auto slot = static_cast<Uint32>(static_cast<Uint64>(id));
+            const auto generation = static_cast<Uint32>(static_cast<Uint64>(id) >> 32);
+            if (slot >= voices.size() || !voices[slot].active || voices[slot].generation != generation)
+                return nullptr;
+            return &voices[slot];
+        }
+
+        bool playing(const VoiceID id) noexcept {
+            return find(id) != nullptr;
+        }
+
+        /**
+         * priority, volume and distance of a playing voice, unknown or finished ids are ignored.
+         * params.loop is ignored too: a looping voice's cursor runs past the clip length, so it is fixed at play(),
+         * stop() and play() again to change it
+         */
+        void set(const VoiceID id, const VoiceParams& params) {
+            if (const auto voice = find(id)) {
+                const auto loop = voice -> params.loop;
+                voice -> params = params;
+                voice -> params.loop = loop;
+                if (voice -> stream)
+                    voice -> stream -> gain(audibility(*voice));
+            }
+        }
+
+        void stop(const VoiceID id) {
+            if (const auto voice = find(id))
+                finish(*voice, true);
+        }
+
+        Stats stats() const noexcept {
+            std::size_t real = 0, active = 0;
+            for (const auto& voice: voices) {
+                active += voice.active;
+                real += voice.stream != nullptr;
+            }
+            return {real, active - real, fading.size()};
+        }
+
+        // once per game frame
+        void update() {
+            const auto now = SDL_GetTicksNS();
+            const auto seconds = last_tick == 0 ? 0.0 : static_cast<double>(now - last_tick) * 1e-9;
+            last_tick = now;
+
+            // drained fade outs go back to the pool
+            std::erase_if(fading, [this](AudioStream* stream) {
+                if (SDL_GetAudioStreamQueued(stream -> handle) > 0 || SDL_GetAudioStreamAvailable(stream -> handle) > 0)
+                    return false;
+                pool.release(*stream);
+                return true;
+            });
+
+            advance(seconds);
+            rank();
+
+            // out first, so the streams coming in can be the ones just handed back
+            for (std::size_t i = 0; i < ranking.size(); ++ i) {
+                auto& voice = voices[ranking[i]];
+                if (voice.stream && (i >= budget || audibility(voice) < audible))
+                    demote(voice);
+            }
+            for (std::size_t i = 0; i < SDL::min(budget, ranking.size()); ++ i) {
+                auto& voice = voices[ranking[i]];
+                if (!voice.stream && audibility(voice) >= audible)
+                    promote(voice);
+            }
+
+            for (auto& voice: voices)
+                if (voice.active && voice.stream && !voice.ending)
+                    fill(voice);
+        }
+
+        static float audibility(const Voice& voice) noexcept {
+            return voice.params.volume / SDL::max(1.0f, voice.params.distance);
+        }
+
+        std::size_t frames(const Voice& voice) const noexcept {
+            return voice.clip -> frames();
+        }
+
+        // frames queued on a real voice's stream and not played yet
+        static Uint64 pending(const Voice& voice) noexcept {
+            const auto queued = SDL_GetAudioStreamQueued(voice.stream -> handle);
+            return queued > 0 ? static_cast<Uint64>(queued) / static_cast<Uint64>(voice.clip -> spec.frame_size()) : 0;
+        }
+
+        void advance(const double seconds) {
+            for (auto& voice: voices) {
+                if (!voice.active)
+                    continue;
+
+                if (voice.stream) {
+                    voice.cursor = static_cast<double>(voice.feed - SDL::min(pending(voice), voice.feed));
+                    if (voice.ending && SDL_GetAudioStreamQueued(voice.stream -> handle) <= 0 && SDL_GetAudioStreamAvailable(voice.stream -> handle) <= 0)
+                        finish(voice, false);
+                    continue;
+                }
+
+                voice.cursor += seconds * voice.clip -> spec.freq;
+                if (!voice.params.loop && voice.cursor >= static_cast<double>(frames(voice)))
+                    finish(voice, false);
+            }
+        }
+
+        void rank() {
+            ranking.clear();
+            for (Uint32 i = 0; i < voices.size(); ++ i)
+                if (voices[i].active)
+                    ranking.push_back(i);
+
+            const auto score = [this](const Uint32 i) noexcept {
+                const auto& voice = voices[i];
+                return std::pair{voice.params.priority, audibility(voice) * (voice.stream ? hysteresis : 1.0f)};
+            };
+            const auto better = [&score](const Uint32 a, const Uint32 b) noexcept {
+                return score(a) > score(b);
+            };
+            if (ranking.size() > budget)
+                std::nth_element(ranking.begin(), ranking.begin() + static_cast<std::ptrdiff_t>(budget), ranking.end(), better);
+        }
+
+        /**
+         * copy frames [from, from + count) of the clip (wrapping when looping) into staging,
+         * times a linear ramp from `begin` to `end` over the first `ramp` frames (the rest at `end`).
+         * returns: frames written
+         */
+        std::size_t render(const Voice& voice, const Uint64 from, std::size_t count, const float begin, const float end, const std::size_t ramp) {
+            const auto length = frames(voice);
+            const auto channels = static_cast<std::size_t>(voice.clip -> spec.channels);
+            const auto samples = reinterpret_cast<const float*>(voice.clip -> data.data());
+            if (length == 0)
+                return 0;
+            if (!voice.params.loop)
+                count = from >= length ? 0 : SDL::min<std::size_t>(count, length - from);
+
+            staging.resize(count * channels);
+            for (std::size_t i = 0; i < count; ++ i) {
+                const auto frame = (from + i) % length;
+                const auto g = i < ramp ? begin + (end - begin) * static_cast<float>(i) / static_cast<float>(ramp) : end;
+                for (std::size_t c = 0; c < channels; ++ c)
+                    staging[i * channels + c] = samples[frame * channels + c] * g;
+            }
+            return count;
+        }
+
+        void submit(Voice& voice, const std::size_t count) {
+            voice.stream -> put({reinterpret_cast<const unsigned char*>(staging.data()), count * voice.clip -> spec.frame_size()});
+            voice.feed += count;
+        }
+
+        void promote(Voice& voice) {
+            voice.stream = &pool.acquire(voice.clip -> spec);
+            voice.stream -> gain(audibility(voice));
+            voice.feed = static_cast<Uint64>(voice.cursor);
+            voice.ending = false;
+
+            const auto n = render(voice, voice.feed, SDL::max(fade_frames, lead), 0.0f, 1.0f, fade_frames);
+            submit(voice, n);
+            if (!voice.params.loop && voice.feed >= frames(voice)) {
+                voice.stream -> flush();
+                voice.ending = true;
+            }
+        }
+
+        // keep the voice alive but virtual, cut the queue where it is playing and fade out from there
+        void demote(Voice& voice) {
+            fade_out(voice);
+            voice.stream = nullptr;
+        }
+
+        void fade_out(Voice& voice) {
+            auto& stream = *voice.stream;
+            // the device must never pull the stream between the clear and the fade, or it cuts hard
+            {
+                auto guard = std::scoped_lock{stream};
+                const auto position = voice.feed - SDL::min(pending(voice), voice.feed);
+                voice.cursor = static_cast<double>(position);
+                const auto n = render(voice, position, fade_frames, 1.0f, 0.0f, fade_frames);
+                SDL_ClearAudioStream(stream.handle);
+                SDL_PutAudioStreamData(stream.handle, staging.data(), static_cast<int>(n * voice.clip -> spec.frame_size()));
+                SDL_FlushAudioStream(stream.handle);
+            }
+            fading.push_back(&stream);
+        }
+
+        void fill(Voice& voice) {
+            const auto queued = pending(voice);
+            if (queued >= lead)
+                return;
+            const auto n = render(voice, voice.feed, lead - queued, 1.0f, 1.0f, 0);
+            submit(voice, n);
+            if (!voice.params.loop && voice.feed >= frames(voice)) {
+                voice.stream -> flush();
+                voice.ending = true;
+            }
+        }
+
+        // fade: cut a real voice with a fade out instead of letting its queue play
+        void finish(Voice& voice, const bool fade) {
+            if (voice.stream) {
+                if (fade)
+                    fade_out(voice);
+                else
+                    pool.release(*voice.stream);
+            }
+            const auto slot = static_cast<Uint32>(&voice - voices.data());
+            voice.stream = nullptr;
+            voice.clip.reset();
+            voice.active = false;
+            ++ voice.generation;
+            free_slots.push_back(slot);
+        }
+    };
+}
+
+#endif //SDL_AUDIO_VOICE_HPP
@@ -0,0 +1,521 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_AUDIO_WAV_HPP
+#define SDL_AUDIO_WAV_HPP
+#include "SDL_audio.hpp"
+#include "SDL_endian.hpp"
+#include "SDL_iostream.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <span>
+
+#if defined(SDL_PLATFORM_WINDOWS)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SDL {
+    namespace wav {
+        constexpr Uint32 riff = fourcc('R', 'I', 'F', 'F');
+        constexpr Uint32 wave = fourcc('W', 'A', 'V', 'E');
+        constexpr Uint32 fmt  = fourcc('f', 'm', 't', ' ');
+        constexpr Uint32 data = fourcc('d', 'a', 't', 'a');
+
+        constexpr Uint16 format_pcm        = 0x0001;
+        constexpr Uint16 format_float      = 0x0003;
+        constexpr Uint16 format_extensible = 0xFFFE;
+
+        constexpr std::size_t riff_header_size  = 12;
+        constexpr std::size_t chunk_header_size = 8;
+
+        inline Uint16 le16(const std::byte* const p) noexcept {
+            Uint16 v;
+            std::memcpy(&v, p, sizeof v);
+            return SDL_Swap16LE(v);
+        }
+
+        inline Uint32 le32(const std::byte* const p) noexcept {
+            Uint32 v;
+            std::memcpy(&v, p, sizeof v);
+            return SDL_Swap32LE(v);
+        }
+
+        struct ChunkHeader {
+            Uint32
+                id;
+            Uint32
+                size;
+
+            // chunks are word aligned, widened first: 0xFFFFFFFF + 1 does not fit a Uint32
+            constexpr Uint64 padded_size() const noexcept {
+                return static_cast<Uint64>(size) + (size & 1);
+            }
+        };
+
+        inline ChunkHeader chunk_header(const std::byte* const p) noexcept {
+            return {le32(p), le32(p + 4)};
+        }
+
+        // checks "RIFF" .... "WAVE"
+        inline void check_riff(const std::span<const std::byte> head) {
+            if (head.size() < riff_header_size || le32(head.data()) != riff || le32(head.data() + 8) != wave) {
+                SDL_SetError("not a RIFF/WAVE file");
+                throw Error{};
+            }
+        }
+
+        /**
+         * decode the body of a "fmt " chunk.
+         * only layouts SDL can play without a decoder are accepted:
+         * 8/16/32 bit integer PCM and 32 bit float, plain or WAVE_FORMAT_EXTENSIBLE
+         */
+        inline AudioSpec parse_fmt(const std::span<const std::byte> body) {
+            if (body.size() < 16) {
+                SDL_SetError("fmt chunk too short");
+                throw Error{};
+            }
+
+            auto tag = le16(body.data());
+            const auto channels = le16(body.data() + 2);
+            const auto freq = le32(body.data() + 4);
+            const auto bits = le16(body.data() + 14);
+
+            // sub format GUID starts with the real tag
+            if (tag == format_extensible) {
+                if (body.size() < 40) {
+                    SDL_SetError("WAVE_FORMAT_EXTENSIBLE fmt chunk too short");
+                    throw Error{};
+                }
+                tag = le16(body.data() + 24);
+            }
+
+            auto format = AudioFormat::UNKNOWN;
+            if (tag == format_pcm && bits == 8)
+                format = AudioFormat::U8;
+            else if (tag == format_pcm && bits == 16)
+                format = AudioFormat::S16LE;
+            else if (tag == format_pcm && bits == 32)
+                format = AudioFormat::S32LE;
+            else if (tag == format_float && bits == 32)
+                format = AudioFormat::F32LE;
+
+            if (format == AudioFormat::UNKNOWN || channels == 0 || freq == 0) {
+                SDL_SetError("unsupported WAVE format: tag %u, %u bits, %u channels", tag, bits, channels);
+                throw Error{};
+            }
+            return {format, static_cast<int>(channels), static_cast<int>(freq)};
+        }
+
+        // where the pcm of a file is, offsets from the start of the RIFF header
+        struct Layout {
+            AudioSpec
+                spec{};
+            Uint64
+                data_begin{0};
+            Uint64
+                data_size{0};
+        };
+
+        /**
+         * walk the chunks up to "data", whatever the file is read through.
+         * read(std::byte* dst, Uint64 offset, Uint64 size) fills dst or throws, offsets only grow.
+         * total is the file size, SDL_MAX_UINT64 if unknown, the data chunk is clipped to it
+         * (streamed recordings may leave its size as 0xFFFFFFFF) and to whole frames
+         */
+        template<typename Read>
+        Layout locate(Read&& read, const Uint64 total) {
+            // extensible is the largest fmt layout we read
+            std::byte scratch[40];
+            if (total < riff_header_size) {
+                SDL_SetError("not a RIFF/WAVE file");
+                throw Error{};
+            }
+            read(scratch, 0, riff_header_size);
+            check_riff({scratch, riff_header_size});
+
+            Layout ret{};
+            bool has_fmt = false;
+            for (Uint64 pos = riff_header_size; pos + chunk_header_size <= total;) {
+                read(scratch, pos, chunk_header_size);
+                const auto header = chunk_header(scratch);
+                const auto body = pos + chunk_header_size;
+
+                if (header.id == fmt) {
+                    const auto n = SDL::min<Uint64>(SDL::min<Uint64>(header.size, sizeof scratch), total - body);
+                    read(scratch, body, n);
+                    ret.spec = parse_fmt({scratch, static_cast<std::size_t>(n)});
+                    has_fmt = true;
+                }
+                else if (header.id == data) {
+                    if (!has_fmt)
+                        break;
+                    ret.data_begin = body;
+                    ret.data_size = SDL::min<Uint64>(header.size, total - body);
+                    ret.data_size -= ret.data_size % ret.spec.frame_size();
+                    return ret;
+                }
+                pos = body + header.padded_size();
+            }
+
+            SDL_SetError(has_fmt ? "WAVE file has no data chunk" : "WAVE file has no fmt chunk before data");
+            throw Error{};
+        }
+    }
+
+    /**
+     * read-only memory mapping of a .wav file.
+     * the header is parsed in place and pcm points straight into the mapping,
+     * so feeding AudioStream::put reads from the page cache without any copy
+     * and only the pages actually played become resident.
+     */
+    struct MappedWav {
+        AudioSpec
+            spec{};
+        std::span<const std::byte>
+            pcm{};
+        const std::byte*
+            base{nullptr};
+        std::size_t
+            length{0};
+#if defined(SDL_PLATFORM_WINDOWS)
+        HANDLE
+            mapping{nullptr};
+#endif
+
+        MappedWav() noexcept=default;
+
+        explicit MappedWav(const std::filesystem::path& path) {
+            map(path);
+            try {
+                parse();
+            }
+            catch (Error&) {
+                unmap();
+                throw;
+            }
+        }
+
+        MappedWav(const MappedWav&)=delete;
+        MappedWav& operator = (const MappedWav&)=delete;
+
+        MappedWav(MappedWav&& other) noexcept {
+            swap(other);
+        }
+        MappedWav& operator = (MappedWav&& other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~MappedWav() noexcept {
+            unmap();
+        }
+
+        void swap(MappedWav& other) noexcept {
+            std::swap(spec, other.spec);
+            std::swap(pcm, other.pcm);
+            std::swap(base, other.base);
+            std::swap(length, other.length);
+#if defined(SDL_PLATFORM_WINDOWS)
+            std::swap(mapping, other.mapping);
+#endif
+        }
+
+        // bytes of pcm, in the form AudioStream::put takes
+        std::span<const unsigned char> data() const noexcept {
+            return {reinterpret_cast<const unsigned char*>(pcm.data()), pcm.size()};
+        }
+
+        // 0 for an empty (default constructed or moved from) mapping
+        std::size_t frames() const noexcept {
+            const auto fs = static_cast<std::size_t>(spec.frame_size());
+            return fs == 0 ? 0 : pcm.size() / fs;
+        }
+
+        // frames [first, first + count) clipped to the payload
+        std::span<const unsigned char> frames(const std::size_t first, const std::size_t count) const noexcept {
+            const auto fs = static_cast<std::size_t>(spec.frame_size());
+            const auto beg = SDL::min(first, frames());
+            const auto n = SDL::min(count, frames() - beg);
+            return data().subspan(beg * fs, n * fs);
+        }
+
+        // only the headers are copied out of the mapping, pcm stays a view of it
+        void parse() {
+            const auto layout = wav::locate([this](std::byte* const dst, const Uint64 offset, const Uint64 size) {
+                std::memcpy(dst, base + offset, static_cast<std::size_t>(size));
+            }, length);
+            spec = layout.spec;
+            pcm = {base + layout.data_begin, static_cast<std::size_t>(layout.data_size)};
+        }
+
+#if defined(SDL_PLATFORM_WINDOWS)
+        void map(const std::filesystem::path& path) {
+            const auto file = CreateFileW(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                SDL_SetError("CreateFileW failed: %lu", GetLastError());
+                throw Error{};
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                CloseHandle(file);
+                SDL_SetError("empty or unreadable file");
+                throw Error{};
+            }
+
+            // the mapping keeps the file alive, the file handle is not needed afterward
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping) {
+                SDL_SetError("CreateFileMappingW failed: %lu", GetLastError());
+                throw Error{};
+            }
+
+            base = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!base) {
+                CloseHandle(mapping);
+                mapping = nullptr;
+                SDL_SetError("MapViewOfFile failed: %lu", GetLastError());
+                throw Error{};
+            }
+            length = static_cast<std::size_t>(size.QuadPart);
+        }
+
+        void unmap() noexcept {
+            if (base)
+                UnmapViewOfFile(base);
+            if (mapping)
+                CloseHandle(mapping);
+            base = nullptr;
+            mapping = nullptr;
+        }
+#else
+        void map(const std::filesystem::path& path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                SDL_SetError("open failed: %s", std::strerror(errno));
+                throw Error{};
+            }
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                SDL_SetError("empty or unreadable file");
+                throw Error{};
+            }
+
+            // the mapping keeps the file alive, the descriptor is not needed afterward
+            const auto addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) {
+                SDL_SetError("mmap failed: %s", std::strerror(errno));
+                throw Error{};
+            }
+            ::posix_madvise(addr, static_cast<std::size_t>(st.st_size), POSIX_MADV_SEQUENTIAL);
+
+            base = static_cast<const std::byte*>(addr);
+            length = static_cast<std::size_t>(st.st_size);
+        }
+
+        void unmap() noexcept {
+            if (base)
+                ::munmap(const_cast<std::byte*>(base), length);
+            base = nullptr;
+        }
+#endif
+    };
+
+    /**
+     * streaming .wav source with bounded memory.
+     * headers are parsed incrementally from the IOStream, then the stream's get-callback
+     * tops the AudioStream up in chunk_size pieces until prefetch chunks are queued,
+     * so playback starts after the first chunk and memory stays at one chunk buffer
+     * no matter how long the track is.
+     *
+     * the input format of the bound AudioStream is switched to the file's spec,
+     * its output format is kept. the AudioStream must outlive the WavStream.
+     */
+    struct WavStream {
+        IOStream
+            io;
+        AudioStream&
+            stream;
+        AudioSpec
+            spec{};
+        Sint64
+            data_begin{0};
+        Uint64
+            data_size{0};
+        Uint64
+            cursor{0};
+        std::size_t
+            chunk_size;
+        std::size_t
+            prefetch;
+        bool
+            loop;
+        std::atomic_bool
+            finished{false};
+        // finished by a read error rather than the end of the data
+        std::atomic_bool
+            failed{false};
+        std::unique_ptr<std::byte[]>
+            chunk;
+        // bytes of chunk read but not yet accepted by the AudioStream (a partial frame included), put again by the next refill
+        std::size_t
+            held{0};
+
+        WavStream(IOStream io, AudioStream& stream, const std::size_t chunk_size=64 * 1024, const std::size_t prefetch=2, const bool loop=false):
+            io{std::move(io)},
+            stream{stream},
+            chunk_size{chunk_size},
+            prefetch{SDL::max<std::size_t>(prefetch, 1)},
+            loop{loop} {
+            if (!this->io)
+                throw Error{};
+
+            parse();
+            // whole frames only
+            this->chunk_size = SDL::max<std::size_t>(chunk_size / spec.frame_size(), 1) * spec.frame_size();
+            chunk = std::make_unique<std::byte[]>(this->chunk_size);
+
+            stream.set_format(spec, stream.format().second);
+            refill(this->chunk_size);
+            stream.add_callback_get(on_get, this);
+        }
+
+        WavStream(const std::filesystem::path& path, AudioStream& stream, const std::size_t chunk_size=64 * 1024, const std::size_t prefetch=2, const bool loop=false):
+            WavStream{
+                IOStream{SDL_IOFromFile(reinterpret_cast<const char*>(path.generic_u8string().c_str()), "rb")},
+                stream, chunk_size, prefetch, loop
+            } {}
+
+        WavStream(const WavStream&)=delete;
+        WavStream& operator = (const WavStream&)=delete;
+
+        ~WavStream() noexcept {
+            SDL_SetAudioStreamGetCallback(stream.handle, nullptr, nullptr);
+        }
+
+        // seek to a frame, takes effect with the next refill
+        void seek(const Uint64 frame) {
+            stream.lock();
+            cursor = SDL::min(frame * spec.frame_size(), data_size);
+            held = 0;
+            const auto ok = SDL_SeekIO(io.get(), data_begin + static_cast<Sint64>(cursor), SDL_IO_SEEK_SET) >= 0;
+            finished = cursor == data_size && !loop;
+            stream.unlock();
+            if (!ok)
+                throw Error{};
+        }
+
+        void read_exact(void* dst, const std::size_t size) {
+            if (SDL_ReadIO(io.get(), dst, size) != size) {
+                if (SDL_GetIOStatus(io.get()) == SDL_IO_STATUS_EOF)
+                    SDL_SetError("unexpected end of WAVE file");
+                throw Error{};
+            }
+        }
+
+        void skip(Sint64 size) {
+            if (SDL_SeekIO(io.get(), size, SDL_IO_SEEK_CUR) >= 0)
+                return;
+            // not seekable, read it away
+            std::byte trash[256];
+            while (size > 0) {
+                const auto n = SDL::min<Sint64>(size, sizeof trash);
+                read_exact(trash, static_cast<std::size_t>(n));
+                size -= n;
+            }
+        }
+
+        // reads forward from the current position, skipping what locate() jumps over, leaves io at the pcm
+        void parse() {
+            const auto start = SDL::max<Sint64>(SDL_TellIO(io.get()), 0);
+            const auto size = SDL_GetIOSize(io.get());
+            const auto total = size > start ? static_cast<Uint64>(size - start) : SDL_MAX_UINT64;
+
+            Uint64 position = 0;
+            const auto layout = wav::locate([this, &position](std::byte* const dst, const Uint64 offset, const Uint64 n) {
+                skip(static_cast<Sint64>(offset - position));
+                read_exact(dst, static_cast<std::size_t>(n));
+                position = offset + n;
+            }, total);
+            spec = layout.spec;
+            data_begin = start + static_cast<Sint64>(layout.data_begin);
+            data_size = layout.data_size;
+        }
+
+        /**
+         * read and queue up to `want` bytes, audio thread (or constructor) only.
+         * a source that is not ready, or a put the stream refuses, is retried by the next refill,
+         * only the end of the data or a read error finishes the stream.
+         * SDL only takes whole frames: a short read keeps its partial frame at the front of chunk
+         * and the next read tops it up
+         */
+        void refill(std::size_t want) noexcept {
+            const auto frame = static_cast<std::size_t>(spec.frame_size());
+            while (want > 0 && !finished) {
+                if (held < frame) {
+                    // data_size and the seek targets are whole frames, a partial frame never reaches the end
+                    if (cursor == data_size) {
+                        if (!loop || SDL_SeekIO(io.get(), data_begin, SDL_IO_SEEK_SET) < 0) {
+                            finished = true;
+                            return;
+                        }
+                        cursor = 0;
+                    }
+
+                    const auto n = static_cast<std::size_t>(SDL::min<Uint64>(SDL::min(SDL::max(want, frame), chunk_size) - held, data_size - cursor));
+                    const auto got = SDL_ReadIO(io.get(), chunk.get() + held, n);
+                    if (got == 0) {
+                        switch (SDL_GetIOStatus(io.get())) {
+                            case SDL_IO_STATUS_NOT_READY:
+                                return;
+                            case SDL_IO_STATUS_EOF:
+                                break;
+                            default:
+                                failed = true;
+                                break;
+                        }
+                        finished = true;
+                        return;
+                    }
+                    cursor += got;
+                    held += got;
+                    continue;
+                }
+
+                const auto whole = held - held % frame;
+                if (!SDL_PutAudioStreamData(stream.handle, chunk.get(), static_cast<int>(whole)))
+                    return;
+                want -= SDL::min(want, whole);
+                held -= whole;
+                std::memmove(chunk.get(), chunk.get() + whole, held);
+            }
+        }
+
+        static void SDLCALL on_get(void* userdata, SDL_AudioStream* handle, const int, int) noexcept {
+            auto& self = *static_cast<WavStream*>(userdata);
+            const auto queued = static_cast<std::size_t>(SDL::max(SDL_GetAudioStreamQueued(handle), 0));
+            const auto target = self.prefetch * self.chunk_size;
+            if (queued < target)
+                self.refill(target - queued);
+        }
+    };
+}
+
+#endif //SDL_AUDIO_WAV_HPP
@@ -0,0 +1,58 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_CPUINFO_HPP
+#define SDL_CPUINFO_HPP
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_version.h>
+
+#include "SDL_stdinc.hpp"
+
+namespace SDL::inline cpuinfo {
+    // compile time guess, large enough for every platform SDL supports
+    constexpr std::size_t cacheline_size = SDL_CACHELINE_SIZE;
+
+    inline int logical_cores() noexcept {
+        return SDL_GetNumLogicalCPUCores();
+    }
+
+    inline int cacheline() noexcept {
+        return SDL_GetCPUCacheLineSize();
+    }
+
+    inline int system_ram() noexcept {
+        return SDL_GetSystemRAM();
+    }
+
+    // returns: 0 when unknown, always on SDL before 3.4.0
+    inline int page_size() noexcept {
+#if SDL_VERSION_ATLEAST(3, 4, 0)
+        return SDL_GetSystemPageSize();
+#else
+        return 0;
+#endif
+    }
+
+    inline std::size_t simd_alignment() noexcept {
+        return SDL_GetSIMDAlignment();
+    }
+
+    inline bool has_sse2() noexcept {
+        return SDL_HasSSE2();
+    }
+
+    inline bool has_sse41() noexcept {
+        return SDL_HasSSE41();
+    }
+
+    inline bool has_avx2() noexcept {
+        return SDL_HasAVX2();
+    }
+
+    inline bool has_neon() noexcept {
+        return SDL_HasNEON();
+    }
+}
+
+#endif //SDL_CPUINFO_HPP
@@ -0,0 +1,27 @@
+//
+// Created by FCWY on 26-10-17.
+//
+
+#ifndef SDL_INTRIN_HPP
+#define SDL_INTRIN_HPP
+#include <SDL3/SDL_intrin.h>
+
+// SDL defines SDL_*_INTRINSICS as soon as the compiler *can* target an instruction set
+// (see SDL_TARGETING), the kernels here are plain inline functions,
+// so they only take the vector path when the whole translation unit is built for it.
+#if defined(SDL_SSE2_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SDL3PLUS_SSE2 1
+#endif
+
+// pshufb, SDL has no SSSE3 level of its own, its SSE4.1 headers bring it along
+#if defined(SDL_SSE4_1_INTRINSICS) && (defined(__SSSE3__) || defined(__AVX__))
+#define SDL3PLUS_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+// AArch64 only, the kernels rely on the A64 conversions (vcvtnq etc.)
+#if defined(SDL_NEON_INTRINSICS) && (defined(__aarch64__) || defined(_M_ARM64))
+#define SDL3PLUS_NEON 1
+#endif
+
+#endif //SDL_INTRIN_HPP
@@ -222,7 +222,7 @@ namespace SDL {
             }
 
             template<typename T>
-            void* free(T* const mem) noexcept {
+            void free(T* const mem) noexcept {
                 return SDL_aligned_free(mem);
             }
         }